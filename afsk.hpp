@@ -1,124 +1,293 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <numeric>
 #include <string>
 #include <vector>
 
+#include "ax25.hpp"
+#include "crc.hpp"
+#include "discriminator.hpp"
+#include "metrics.hpp"
+#include "nco.hpp"
+#include "profile.hpp"
+#include "stack_guards.hpp"
 #include "utils.hpp"
 
 struct AFSK
 {
-	static const int baud_rate = 1200;			// adjust sample_rate accordingly when changing this
-	static const size_t sample_rate = 8 * baud_rate;	// easier to demod
+	// pick another AFSKProfile to change these
+	using profile = Bell202;
+
+	static const int baud_rate = profile::baud_rate;
+	static const size_t sample_rate = profile::sample_rate;	// 8 * baud_rate, easier to demod
+
+	static const int mark_freq = profile::mark_freq;
+	static const int space_freq = profile::space_freq;
 
 	class Encoder
 	{
 		struct synth_state
 		{
-			// current frequency
-			uintmax_t freq = 1200;
+			synth_state(size_t rate)
+				: nco(rate, amplitude),
+				  rate(rate),
+				  mark_step(nco.step(mark_freq)),
+				  space_step(nco.step(space_freq))
+			{
+				nco.tune(mark_step);
+			}
+
+			// the oscillator keeps its phase across bits, bytes and frames
+			NCO nco;
+
+			// output sample rate, doesn't have to be a multiple of the baud rate
+			size_t rate;
+
+			// phase increments of both tones
+			uint32_t mark_step, space_step;
+
+			// current tone
+			bool marking = true;
 
 			// internal bit counter - needed for proper timing
-			uintmax_t total_bits = 0;
+			uint64_t total_bits = 0;
 
-			// current LUT index
-			uintmax_t idx = 0;
+			// samples written so far
+			size_t samples = 0;
 		};
 
 	public:
-		// Encodes an AFSK NRZI message
-		static std::vector<uint8_t> Encode(
+		// baud step - a number of samples comprising 1 baud
+		static const size_t baud_step = sample_rate / baud_rate;
+
+		// fraction of full scale, leaves headroom when channels are mixed
+		static constexpr double amplitude = 0.5;
+
+		// Encodes an AFSK NRZI message into 8-bit unsigned, 16-bit signed or float samples at any rate
+		// begin_marker_size / 2 zero bytes and end_marker_size - begin_marker_size / 2 flags go before the message,
+		// end_marker_size - end_marker_size / 2 flags and end_marker_size / 2 zero bytes after it
+		template <typename T = uint8_t>
+		static std::vector<T> Encode(
 			const std::vector<uint8_t> &message,
 			int begin_marker_size = 1,
-			int end_marker_size = 1)
+			int end_marker_size = 1,
+			size_t rate = sample_rate)
 		{
-			const int samples_required = sample_rate / baud_rate * message.size();
+			if (begin_marker_size < 0 || end_marker_size < 0 || begin_marker_size / 2 > end_marker_size)
+			{
+				throw EXCEPTION("Bad marker sizes " + std::to_string(begin_marker_size) + ", " +
+				                std::to_string(end_marker_size));
+			}
 
-			std::vector<uint8_t> result;
-			result.reserve(1 + begin_marker_size + samples_required + end_marker_size + 1);
+			const size_t leading_zeros = begin_marker_size / 2;
+			const size_t opening_flags = end_marker_size - begin_marker_size / 2;
+			const size_t closing_flags = end_marker_size - end_marker_size / 2;
+			const size_t trailing_zeros = end_marker_size / 2;
 
-			synth_state state;
+			std::vector<T> result(max_samples(
+				leading_zeros + opening_flags + closing_flags + trailing_zeros, message.size(), rate));
+
+			synth_state state(rate);
+			T *out = result.data();
 
 			// write several 0x7E's to allow the receiver to synchronize
-			synth(std::vector<uint8_t>(begin_marker_size / 2, 0x00), false, state, result);
-			synth(std::vector<uint8_t>(end_marker_size - begin_marker_size / 2, 0x7E), false, state, result);
-			synth(message, true, state, result);
+			synth_repeat(0x00, leading_zeros, state, out);
+			synth_repeat(0x7E, opening_flags, state, out);
+			synth(message.data(), message.size(), state, out);
 
 			// and more 0x7E's for good measure
-			synth(std::vector<uint8_t>(end_marker_size - end_marker_size / 2, 0x7E), false, state, result);
-			synth(std::vector<uint8_t>(end_marker_size / 2, 0x00), false, state, result);
+			synth_repeat(0x7E, closing_flags, state, out);
+			synth_repeat(0x00, trailing_zeros, state, out);
 
+			result.resize(state.samples);
 			return result;
 		}
 
-	private:
-		static void synth(
-			const std::vector<uint8_t> &message,
-			const bool escape,
-			synth_state &state,
-			std::vector<uint8_t> &output)
+		struct tx_options
 		{
-			// frequency step - a minimum change in signal frequency that is for current sample rate
-			// this is actually reduced to 1 Hz when calculating samples
-			const int freq_step = sample_rate / utils::lut_size;
+			tx_options(size_t txdelay = 32, size_t gap = 2, size_t txtail = 4)
+				: txdelay(txdelay),
+				  gap(gap),
+				  txtail(txtail)
+			{
+			}
 
-			// baud step - a number of samples comprising 1 baud
-			const int baud_step = sample_rate / baud_rate;
+			// flags before the first frame, lets the receiver's squelch open and its clock settle
+			size_t txdelay;
 
-			int ones = 0;
-			float mul = 1;
+			// flags between frames
+			size_t gap;
+
+			// flags after the last frame, so the end isn't clipped when the transmitter keys down
+			size_t txtail;
+		};
 
-			for (uint16_t byte : message)
+		// Synthesizes several frames into one phase-continuous transmission in a caller-supplied buffer
+		// Nothing is allocated: frames are appended one by one, the buffer is only checked once per frame
+		template <typename T = uint8_t>
+		class Transmission
+		{
+		public:
+			Transmission(T *out, size_t capacity, const tx_options &options = tx_options(), size_t rate = sample_rate)
+				: out(out),
+				  capacity(capacity),
+				  options(options),
+				  state(rate)
 			{
-				for (int bit = 0; bit < 8; ++bit)
+			}
+
+			// appends a frame (without flags and unstuffed), returns false if the buffer can't fit it
+			bool add(const uint8_t *frame, size_t size)
+			{
+				const size_t flags = frames ? options.gap : options.txdelay;
+
+				// leave room for the tail as well
+				if (state.samples + max_samples(flags + 1 + options.txtail, size, state.rate) > capacity)
 				{
-					++state.total_bits;
+					return false;
+				}
 
-					if (escape && ++ones == 6)
-					{
-						ones = 0;
-						byte <<= 1;								// holy fuck-knuckles
-						--bit;
-					}
+				synth_repeat(0x7E, flags, state, out);
+				synth(frame, size, state, out);
+				++frames;
 
-					// NRZI encoding
-					if ((byte & 0x01) == 0)
-					{
-						// wiggle frequency if bit is unset
-						wiggle(state.freq, mul);
-						ones = 0;
-					}
+				return true;
+			}
+
+			bool add(const std::vector<uint8_t> &frame)
+			{
+				return add(frame.data(), frame.size());
+			}
 
-					byte >>= 1;
+			// writes the tail, returns the number of samples in the buffer
+			size_t finish()
+			{
+				if (frames)
+				{
+					synth_repeat(0x7E, std::max<size_t>(options.txtail, 1), state, out);
+				}
 
-					// write samples
-					while (output.size() < state.total_bits * baud_step)
-					{
-						// do a LUT lookup
-						uint8_t x = 0.5 * utils::lut[(state.idx / freq_step) % utils::lut_size];
+				return state.samples;
+			}
+
+			size_t size() const
+			{
+				return state.samples;
+			}
 
-						// write sample
-						output.push_back(x);
+		private:
+			T *out;
+			const size_t capacity;
+			const tx_options options;
 
-						// advance in LUT
-						state.idx += state.freq;
-					}
+			synth_state state;
+			size_t frames = 0;
+		};
+
+		// Encodes a batch of packets (anything with Encode(std::vector<uint8_t> &), e.g. APRSPacket)
+		// into one transmission, sets samples to the number written to out
+		// returns the number of packets encoded: the first ones, up to the first that didn't fit
+		// max_samples(packets.size() * (gap + 1) + txdelay + txtail, total frame bytes, rate) is always enough
+		template <typename Packets, typename T>
+		static size_t EncodeBatch(
+			Packets &packets,
+			T *out,
+			size_t capacity,
+			size_t &samples,
+			const tx_options &options = tx_options(),
+			size_t rate = sample_rate)
+		{
+			Transmission<T> tx(out, capacity, options, rate);
+
+			// one scratch frame for the whole batch
+			std::vector<uint8_t> frame;
+			frame.reserve(Decoder::max_frame_size);
+
+			size_t encoded = 0;
+
+			for (auto &packet : packets)
+			{
+				packet.Encode(frame);
+
+				if (!tx.add(frame))
+				{
+					break;
 				}
+
+				++encoded;
 			}
+
+			samples = tx.finish();
+			return encoded;
 		}
 
-		static void wiggle(uintmax_t &freq, float &mul)
+		// upper bound of samples needed for a number of flags plus frame bytes (at most 1 in 6 bits is stuffed)
+		static size_t max_samples(size_t flags, size_t bytes, size_t rate = sample_rate)
 		{
-			constexpr uintmax_t freq_hi = 2200;
-			constexpr uintmax_t freq_lo = 1200;
+			const uint64_t bits = flags * 8 + bytes * 8 * 6 / 5 + 1;
+			return (bits * rate + baud_rate - 1) / baud_rate;
+		}
 
-			if (freq == freq_lo)
+	private:
+		template <typename T>
+		static void synth_repeat(uint8_t byte, size_t count, synth_state &state, T *&output)
+		{
+			int ones = 0;
+
+			for (size_t i = 0; i < count; ++i)
 			{
-				freq = freq_hi;
-				mul = 0.8f;
+				synth_byte(byte, false, ones, state, output);
 			}
-			else
+		}
+
+		template <typename T>
+		static void synth(const uint8_t *message, size_t size, synth_state &state, T *&output)
+		{
+			int ones = 0;
+
+			for (size_t i = 0; i < size; ++i)
 			{
-				freq = freq_lo;
-				mul = 0.8f;
+				synth_byte(message[i], true, ones, state, output);
+			}
+		}
+
+		template <typename T>
+		static void synth_byte(
+			uint16_t byte,
+			const bool escape,
+			int &ones,
+			synth_state &state,
+			T *&output)
+		{
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				++state.total_bits;
+
+				if (escape && ++ones == 6)
+				{
+					ones = 0;
+					byte <<= 1;								// holy fuck-knuckles
+					--bit;
+				}
+
+				// NRZI encoding
+				if ((byte & 0x01) == 0)
+				{
+					// switch tones if bit is unset
+					state.marking = !state.marking;
+					state.nco.tune(state.marking ? state.mark_step : state.space_step);
+					ones = 0;
+				}
+
+				byte >>= 1;
+
+				// write samples up to the end of this bit, computed from the bit count so rounding never drifts
+				const size_t end = state.total_bits * state.rate / baud_rate;
+				output = state.nco.generate(output, end - state.samples);
+				state.samples = end;
 			}
 		}
 	};
@@ -126,6 +295,15 @@ struct AFSK
 	class Decoder
 	{
 	public:
+		// longest possible AX.25 frame: 10 addresses, control, PID, 256 bytes of info and FCS
+		static const size_t max_frame_size = 10 * 7 + 2 + 256 + 2;
+
+		// samples per baud, which is also the correlation window
+		static const size_t window_size = sample_rate / baud_rate;
+
+		// number of bauds handed to the discriminator at once
+		static constexpr size_t batch_size = 256;
+
 		// slow but easier to read
 		static std::vector<uint8_t> demod_naive(
 			const std::vector<uint8_t> &samples,
@@ -136,7 +314,7 @@ struct AFSK
 
 			for (size_t i = test_shift; i < samples.size() - 8 - test_shift; i += 8)
 			{
-				frequencies.push_back(fft2(samples, i) > 0);
+				frequencies.push_back(fft2(samples.data() + i) > 0);
 			}
 
 			// decode the frequencies from NZRI
@@ -231,42 +409,52 @@ struct AFSK
 				DEMOD_START_STOP = 1,
 				DEMOD_BIT_READ,
 				DEMOD_BIT_SKIP,
+				DEMOD_ABORT,
 			};
 
 			bool last_freq = 0;
+
+			// last 8 raw (NRZI-decoded, still stuffed) bits - flags are looked for here
+			uint8_t raw_buf = 0;
+
+			// destuffed data bits of the byte being assembled
 			uint8_t byte_buf = 0;
-			int escape = 0;
-			int start = 0;
-			int bit = 0;
+			int bits = 0;
+
 			int ones = 0;
 			bool decoding = 0;
+
+			// counts flags and aborts when set
+			Metrics *metrics = nullptr;
 		};
 
 		// optimized
 		static int demod_iter(demod_state &state, const std::vector<uint8_t> &samples, size_t i)
 		{
-			++state.bit;
+			return demod_bit(state, fft2(samples.data() + i) > 0);
+		}
 
-			bool freq = fft2(samples, i) > 0;
+		// feeds a single baud worth of frequency decision into the bit/byte state machine
+		static int demod_bit(demod_state &state, bool freq)
+		{
 			bool is_set = state.last_freq == freq;
 			state.last_freq = freq;
 
-			state.byte_buf >>= 1;
-			state.byte_buf |= (is_set << 7);
+			state.raw_buf >>= 1;
+			state.raw_buf |= (is_set << 7);
 
-			if (!state.escape)
+			if (state.raw_buf == 0x7E)
 			{
-				if (state.byte_buf == 0x7E)
+				if (state.metrics)
 				{
-					state.decoding = true;
-					state.byte_buf = 0;
-					state.start = state.bit;
-					return -demod_state::DEMOD_START_STOP;
+					state.metrics->add(Metrics::FLAGS);
 				}
-			}
-			else
-			{
-				--state.escape;
+
+				state.decoding = true;
+				state.byte_buf = 0;
+				state.bits = 0;
+				state.ones = 0;
+				return -demod_state::DEMOD_START_STOP;
 			}
 
 			if (!state.decoding)
@@ -276,29 +464,42 @@ struct AFSK
 
 			if (is_set)
 			{
-				++state.ones;
+				// 7 ones in a row can't be anything but an abort or an idle line
+				if (++state.ones == 7)
+				{
+					if (state.metrics)
+					{
+						state.metrics->add(Metrics::STUFFING_ERRORS);
+					}
+
+					state.decoding = false;
+					return -demod_state::DEMOD_ABORT;
+				}
 			}
 			else
 			{
+				// a zero after 5 ones is a stuffed bit - drop it
 				if (state.ones == 5)
 				{
-					state.byte_buf <<= 1;
-					++state.start;
 					state.ones = 0;
-					state.escape = 2;
 					return -demod_state::DEMOD_BIT_SKIP;
 				}
 
 				state.ones = 0;
 			}
 
-			if (((state.bit - state.start) & 0b0111) != 0)
+			// bits are received backwards
+			state.byte_buf >>= 1;
+			state.byte_buf |= (is_set << 7);
+
+			if (++state.bits != 8)
 			{
 				return -demod_state::DEMOD_BIT_SKIP;
 			}
 
 			auto result = state.byte_buf;
 			state.byte_buf = 0;
+			state.bits = 0;
 			return result;
 		}
 
@@ -310,9 +511,102 @@ struct AFSK
 			std::vector<uint8_t> buf;
 			buf.reserve(512);
 
-			for (size_t i = test_shift, bit = 0; i < samples.size() - 8 - test_shift; i += 8, ++bit)
+			// positions are correlated in batches, then fed to the state machine one by one
+			const size_t end = samples.size() > window_size + test_shift ? samples.size() - window_size - test_shift : 0;
+			int energies[batch_size];
+
+			for (size_t i = test_shift; i < end; i += batch_size * window_size)
 			{
-				auto result = demod_iter(state, samples, i);
+				const size_t count = std::min(batch_size, (end - i + window_size - 1) / window_size);
+				Discriminator::batch(samples.data() + i, window_size, count, energies);
+
+				for (size_t k = 0; k < count; ++k)
+				{
+					auto result = demod_bit(state, energies[k] > 0);
+
+					switch (result)
+					{
+						case -demod_state::DEMOD_START_STOP:
+
+							if (buf.size() > 15)
+							{
+								return buf;
+							}
+							else
+							{
+								buf.clear();
+							}
+
+							break;
+
+						case -demod_state::DEMOD_ABORT:
+							buf.clear();
+							break;
+
+						case -demod_state::DEMOD_BIT_SKIP:
+							break;
+
+						default:
+							buf.push_back(result);
+					}
+				}
+			}
+
+			return { };
+		}
+
+		// sliding-window counterpart of fft2
+		using Correlator = ToneCorrelator<profile>;
+
+		// bit state machine together with the frame being assembled
+		// every bit of the frame is kept with a soft value (how clear the tone decisions behind it were),
+		// so a frame that fails the FCS can be repaired by flipping its least confident bits
+		class Framer
+		{
+		public:
+			// raw bits of the longest frame, bit stuffing and closing flag included
+			static const size_t max_raw_bits = max_frame_size * 8 * 6 / 5 + 8;
+
+			Framer()
+			{
+				buf.reserve(max_frame_size);
+				raw.reserve(max_raw_bits);
+				soft.reserve(max_raw_bits);
+			}
+
+			// feeds one frequency decision, returns true when frame() holds a complete frame
+			// the frame stays valid until the next call
+			bool push(bool freq)
+			{
+				return push(freq ? 1 : -1);
+			}
+
+			// same, from a discriminator output: the sign is the decision and the magnitude its confidence
+			bool push(int energy)
+			{
+				if (complete)
+				{
+					complete = false;
+					buf.clear();
+					clear_raw();
+				}
+
+				const bool freq = energy > 0;
+				const bool is_set = state.last_freq == freq;
+				const bool recording = state.decoding;
+
+				// an NRZI bit is only as reliable as the weaker of the two tones it's made of
+				const uint32_t magnitude = energy < 0 ? -int64_t(energy) : energy;
+				const uint32_t confidence = std::min(magnitude, last_magnitude);
+				last_magnitude = magnitude;
+
+				if (recording && raw.size() < max_raw_bits)
+				{
+					raw.push_back(is_set);
+					soft.push_back(confidence);
+				}
+
+				auto result = demod_bit(state, freq);
 
 				switch (result)
 				{
@@ -320,47 +614,537 @@ struct AFSK
 
 						if (buf.size() > 15)
 						{
-							return buf;
-						}
-						else
-						{
-							buf.clear();
+							complete = true;
+							count_frame();
+							return true;
 						}
 
+						buf.clear();
+						clear_raw();
+						break;
+
+					case -demod_state::DEMOD_ABORT:
+						buf.clear();
+						clear_raw();
 						break;
 
 					case -demod_state::DEMOD_BIT_SKIP:
 						break;
 
 					default:
+
+						// no valid frame is that long - drop it and wait for the next flag
+						if (buf.size() == max_frame_size)
+						{
+							buf.clear();
+							clear_raw();
+							state.decoding = false;
+							break;
+						}
+
 						buf.push_back(result);
 				}
+
+				return false;
 			}
 
-			return { };
-		}
+			const std::vector<uint8_t> &frame() const
+			{
+				return buf;
+			}
 
-	private:
-		static int fft2(std::vector<uint8_t> data, int idx)
+			// true between an opening flag and the end of the frame
+			bool synced() const
+			{
+				return state.decoding;
+			}
+
+			// counts flags, frames, FCS failures, aborts and repairs into metrics from now on
+			// frames = false leaves frames, FCS failures and repairs to the caller, which may see them from several framers
+			void attach(Metrics *metrics, bool frames = true)
+			{
+				state.metrics = metrics;
+				count_frames = frames;
+			}
+
+			// tries to repair the complete frame by flipping up to max_flips (1 or 2) of its least confident bits
+			// at most max_attempts candidates are checked, most of them against the CRC syndromes in O(1)
+			// returns true if frame() now holds a frame with a valid FCS and a plausible AX.25 header
+			bool recover(size_t max_flips = 2, size_t max_attempts = 256)
+			{
+				if (!complete || raw.size() < 8 + 8 * 17)
+				{
+					return false;
+				}
+
+				// the closing flag isn't part of the frame
+				const size_t n = raw.size() - 8;
+
+				if (!destuff(raw.data(), n, scratch, data_index.data()) || scratch.size() < 3)
+				{
+					return false;
+				}
+
+				const size_t data_bits = scratch.size() * 8;
+				CRC16::syndromes(data_bits, syndrome.data());
+				const uint16_t residue = CRC16::update(CRC16::init, scratch.data(), scratch.size());
+
+				// the least confident bits are the likeliest to be wrong
+				const size_t k = std::min(candidates.size(), n);
+				std::iota(order.begin(), order.begin() + n, 0);
+				std::partial_sort(order.begin(), order.begin() + k, order.begin() + n, [this](uint16_t a, uint16_t b) {
+					return soft[a] < soft[b];
+				});
+
+				for (size_t i = 0; i < k; ++i)
+				{
+					candidates[i] = order[i];
+				}
+
+				size_t attempts = 0;
+
+				auto attempt = [&](std::initializer_list<size_t> flips) {
+					if (attempts++ >= max_attempts)
+					{
+						return false;
+					}
+
+					// flips that leave the bit stuffing alone change the CRC by their syndromes only
+					bool simple = true;
+					uint16_t delta = 0;
+
+					for (size_t p : flips)
+					{
+						simple = simple && isolated(p, flips) && data_index[p] >= 0;
+						delta ^= simple ? syndrome[data_index[p]] : 0;
+					}
+
+					if (simple && (residue ^ delta) != CRC16::good_residue)
+					{
+						return false;
+					}
+
+					for (size_t p : flips)
+					{
+						raw[p] ^= 1;
+					}
+
+					const bool fixed = destuff(raw.data(), n, scratch, nullptr) &&
+						CRC16::check(scratch.data(), scratch.size()) &&
+						plausible(scratch);
+
+					if (!fixed)
+					{
+						for (size_t p : flips)
+						{
+							raw[p] ^= 1;
+						}
+
+						return false;
+					}
+
+					buf.swap(scratch);
+
+					if (state.metrics && count_frames)
+					{
+						state.metrics->add(Metrics::RECOVERED);
+					}
+
+					return true;
+				};
+
+				for (size_t i = 0; i < k; ++i)
+				{
+					if (attempt({candidates[i]}))
+					{
+						return true;
+					}
+				}
+
+				if (max_flips < 2)
+				{
+					return false;
+				}
+
+				// a single wrong tone decision flips two neighbouring NRZI bits
+				for (size_t i = 0; i < k; ++i)
+				{
+					const size_t p = candidates[i];
+					if ((p + 1 < n && attempt({p, p + 1})) || (p > 0 && attempt({p - 1, p})))
+					{
+						return true;
+					}
+				}
+
+				for (size_t i = 0; i < k; ++i)
+				{
+					for (size_t j = i + 1; j < k; ++j)
+					{
+						if (attempt({candidates[i], candidates[j]}))
+						{
+							return true;
+						}
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			void clear_raw()
+			{
+				raw.clear();
+				soft.clear();
+			}
+
+			// the FCS is only checked here when metrics are on, decoders check it themselves anyway
+			void count_frame()
+			{
+				if (Metrics::enabled && state.metrics && count_frames)
+				{
+					state.metrics->add(Metrics::FRAMES);
+
+					if (!CRC16::check(buf.data(), buf.size()))
+					{
+						state.metrics->add(Metrics::FCS_FAILURES);
+					}
+				}
+			}
+
+			// flipping raw bit p can't add or remove a stuffed bit as long as the run of ones around it stays under 5
+			// and no other flip is close enough to change that
+			bool isolated(size_t p, std::initializer_list<size_t> flips) const
+			{
+				for (size_t q : flips)
+				{
+					if (q != p && (q > p ? q - p : p - q) <= 6)
+					{
+						return false;
+					}
+				}
+
+				size_t ones = 1;
+				for (size_t q = p; q > 0 && raw[q - 1]; --q)
+				{
+					++ones;
+				}
+				for (size_t q = p + 1; q < raw.size() && raw[q]; ++q)
+				{
+					++ones;
+				}
+
+				return ones < 5;
+			}
+
+			// removes the bit stuffing from n raw bits, data_index (if given) receives the data bit of every raw bit or -1
+			static bool destuff(const uint8_t *bits, size_t n, std::vector<uint8_t> &out, int16_t *data_index)
+			{
+				out.clear();
+
+				int ones = 0;
+				uint8_t byte = 0;
+				size_t count = 0;
+
+				for (size_t p = 0; p < n; ++p)
+				{
+					if (bits[p])
+					{
+						// 6 ones is a flag or an abort, neither belongs inside a frame
+						if (++ones == 6)
+						{
+							return false;
+						}
+					}
+					else
+					{
+						if (ones == 5)
+						{
+							ones = 0;
+							if (data_index)
+							{
+								data_index[p] = -1;
+							}
+							continue;
+						}
+
+						ones = 0;
+					}
+
+					if (data_index)
+					{
+						data_index[p] = count;
+					}
+
+					byte = (byte >> 1) | (bits[p] << 7);
+
+					if (++count % 8 == 0)
+					{
+						if (out.size() == max_frame_size)
+						{
+							return false;
+						}
+
+						out.push_back(byte);
+					}
+				}
+
+				return count % 8 == 0;
+			}
+
+			// a repaired frame must at least look like AX.25, which keeps the odds of a false repair down
+			static bool plausible(const std::vector<uint8_t> &frame)
+			{
+				AX25FrameView view(frame.data(), frame.size());
+
+				if (!view.IsValid())
+				{
+					return false;
+				}
+
+				for (size_t i = 0; i < 2 + view.Digipeaters(); ++i)
+				{
+					const uint8_t *address = frame.data() + i * AX25Address::size;
+
+					for (size_t c = 0; c < AX25Address::callsign_size; ++c)
+					{
+						const char ch = address[c] >> 1;
+						if ((address[c] & 1) || !((ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == ' '))
+						{
+							return false;
+						}
+					}
+				}
+
+				return true;
+			}
+
+			demod_state state;
+			std::vector<uint8_t> buf;
+			bool complete = false;
+			bool count_frames = true;
+
+			// raw (NRZI-decoded, still stuffed) bits since the opening flag, and their confidence
+			std::vector<uint8_t> raw;
+			std::vector<uint32_t> soft;
+			uint32_t last_magnitude = 0;
+
+			// recovery scratch space, sized once so recovering never allocates
+			std::vector<uint8_t> scratch = std::vector<uint8_t>(max_frame_size);
+			std::array<int16_t, max_raw_bits> data_index;
+			std::array<uint16_t, max_frame_size * 8> syndrome;
+			std::array<uint16_t, max_raw_bits> order;
+			std::array<size_t, 16> candidates;
+		};
+
+		// push-style decoder for continuous audio
+		// samples may be fed in chunks of any size, every complete frame is handed to the callback
+		class Stream
 		{
-			int8_t coeffloi[] = {64, 45, 0, -45, -64, -45, 0, 45};
-			int8_t coeffloq[] = {0, 45, 64, 45, 0, -45, -64, -45};
-			int8_t coeffhii[] = {64, 8, -62, -24, 55, 39, -45, -51};
-			int8_t coeffhiq[] = {0, 63, 17, -59, -32, 51, 45, -39};
+		public:
+			using frame_callback = std::function<void(const std::vector<uint8_t> &)>;
 
-			int outloi = 0, outloq = 0, outhii = 0, outhiq = 0;
+			Stream(frame_callback on_frame, size_t test_shift = 0)
+				: on_frame(std::move(on_frame)),
+				  skip(test_shift)
+			{
+			}
 
-			for (int ii = 0; ii < 8; ii++)
+			void feed(const uint8_t *samples, size_t count)
 			{
-				int sample = data[ii + idx] - 128;
-				outloi += sample * coeffloi[ii];
-				outloq += sample * coeffloq[ii];
-				outhii += sample * coeffhii[ii];
-				outhiq += sample * coeffhiq[ii];
+				if (metrics)
+				{
+					metrics->add(Metrics::SAMPLES, count);
+				}
+
+				// align to the requested phase first
+				size_t i = std::min(skip, count);
+				skip -= i;
+
+				// complete a window left over from the previous chunk
+				if (fill)
+				{
+					size_t n = std::min(window.size() - fill, count - i);
+					std::copy(samples + i, samples + i + n, window.data() + fill);
+					fill += n;
+					i += n;
+
+					if (fill < window.size())
+					{
+						return;
+					}
+
+					fill = 0;
+					process(fft2(window.data()));
+				}
+
+				// whole bauds are correlated in place, in batches
+				while (i + window.size() <= count)
+				{
+					const size_t n = std::min(batch_size, (count - i) / window.size());
+					Discriminator::batch(samples + i, window.size(), n, energies);
+
+					for (size_t k = 0; k < n; ++k)
+					{
+						process(energies[k]);
+					}
+
+					i += n * window.size();
+				}
+
+				// and the tail is kept for the next chunk
+				fill = count - i;
+				std::copy(samples + i, samples + count, window.data());
+			}
+
+			void feed(const std::vector<uint8_t> &samples)
+			{
+				feed(samples.data(), samples.size());
+			}
+
+			// number of frames handed to the callback so far
+			size_t frames() const
+			{
+				return frames_emitted;
+			}
+
+			// counts into metrics from now on, see Metrics
+			void attach(Metrics *metrics)
+			{
+				this->metrics = metrics;
+				framer.attach(metrics);
+			}
+
+		private:
+			void process(int energy)
+			{
+				if (framer.push(energy))
+				{
+					++frames_emitted;
+					on_frame(framer.frame());
+				}
 			}
 
-			return (outhii >> 8) * (outhii >> 8) + (outhiq >> 8) * (outhiq >> 8) -
-			       (outloi >> 8) * (outloi >> 8) - (outloq >> 8) * (outloq >> 8);
+			frame_callback on_frame;
+			Framer framer;
+			Metrics *metrics = nullptr;
+
+			std::array<uint8_t, window_size> window;
+			int energies[batch_size];
+			size_t fill = 0;
+			size_t skip;
+
+			size_t frames_emitted = 0;
+		};
+
+		// single pass decoder with clock recovery
+		// the discriminator runs on every sample and a digital PLL decides when to sample a bit:
+		// the PLL wraps once per baud and every tone transition pulls it towards the middle of the bit,
+		// so transmitters with a slightly-off baud rate or sound cards with a drifting clock still decode
+		class PLLStream
+		{
+		public:
+			using frame_callback = std::function<void(const std::vector<uint8_t> &)>;
+
+			// fix_bits > 0 tries to repair frames failing the FCS by flipping up to that many bits, see Framer::recover
+			PLLStream(frame_callback on_frame, size_t fix_bits = 0)
+				: on_frame(std::move(on_frame)),
+				  fix_bits(fix_bits)
+			{
+			}
+
+			void feed(const uint8_t *samples, size_t count)
+			{
+				if (metrics)
+				{
+					metrics->add(Metrics::SAMPLES, count);
+				}
+
+				correlator.feed(samples, count, [this](int energy) {
+					process(energy);
+				});
+			}
+
+			void feed(const std::vector<uint8_t> &samples)
+			{
+				feed(samples.data(), samples.size());
+			}
+
+			// number of frames handed to the callback so far
+			size_t frames() const
+			{
+				return frames_emitted;
+			}
+
+			// counts into metrics from now on, see Metrics
+			void attach(Metrics *metrics)
+			{
+				this->metrics = metrics;
+				framer.attach(metrics);
+			}
+
+			// frames that only passed the FCS after flipping bits
+			size_t recovered() const
+			{
+				return frames_recovered;
+			}
+
+		private:
+			// PLL advance per sample - a full 32-bit turn per baud
+			static const uint32_t pll_step = uint32_t((uint64_t(1) << 32) / window_size);
+
+			// how much of the phase error is kept on a transition, out of 256
+			// a locked PLL trusts its own timing more than a single transition
+			static const int64_t inertia_locked = 190;
+			static const int64_t inertia_searching = 128;
+
+			void process(int energy)
+			{
+				const bool freq = energy > 0;
+
+				// tone transitions happen half a baud away from the optimal sampling point
+				if (freq != last_freq)
+				{
+					last_freq = freq;
+					const int64_t inertia = framer.synced() ? inertia_locked : inertia_searching;
+					pll = int32_t(pll * inertia / 256);
+				}
+
+				const int32_t previous = pll;
+				pll = int32_t(uint32_t(pll) + pll_step);
+
+				// sample when the PLL wraps around
+				if (previous >= 0 && pll < 0 && framer.push(energy))
+				{
+					const auto &frame = framer.frame();
+
+					if (fix_bits && !CRC16::check(frame.data(), frame.size()) && framer.recover(fix_bits))
+					{
+						++frames_recovered;
+					}
+
+					++frames_emitted;
+					on_frame(framer.frame());
+				}
+			}
+
+			frame_callback on_frame;
+			Framer framer;
+			Metrics *metrics = nullptr;
+			DiscriminatorStream correlator;
+
+			int32_t pll = 0;
+			bool last_freq = false;
+
+			size_t fix_bits;
+			size_t frames_emitted = 0;
+			size_t frames_recovered = 0;
+		};
+
+		// correlates one baud worth of samples starting at data against both tones
+		// returns > 0 for 2200 Hz, < 0 for 1200 Hz
+		static int fft2(const uint8_t *data)
+		{
+			return Discriminator::window(data);
 		}
 	};
-};
+};
\ No newline at end of file
@@ -1,35 +1,116 @@
 #pragma once
+#include <ctime>
 #include <string>
 #include <vector>
 #include <stdexcept>
 
+#include "ax25.hpp"
+#include "crc.hpp"
+#include "metrics.hpp"
 #include "stack_guards.hpp"
+#include "status.hpp"
 
 // APRS over AX.25 encoder/decoder
 class APRSPacket
 {
   public:
     std::string sender_callsign;
-    uint8_t sender_ssid;
+    uint8_t sender_ssid = 0;
     std::string custom_data;
 
+    // digipeater path, e.g. {"WIDE1-1", "WIDE2-1"}; repeated hops are marked with a trailing '*'
+    std::vector<std::string> path;
+
+    APRSPacket() = default;
+
     APRSPacket(
         const std::string &sender_callsign,
         uint8_t sender_ssid,
-        const std::string &custom_data = "")
+        const std::string &custom_data = "",
+        const std::vector<std::string> &path = {})
         : sender_callsign(sender_callsign),
           sender_ssid(sender_ssid),
-          custom_data(custom_data)
+          custom_data(custom_data),
+          path(path)
     {
-        BEGIN();
-        END();
     }
 
-    std::vector<uint8_t> Encode()
+    // throwing wrappers around TryEncode/TryDecode, for callers that treat any failure as fatal
+    std::vector<uint8_t> Encode() const
     {
-        BEGIN();
-
         std::vector<uint8_t> packet;
+        Encode(packet);
+        return packet;
+    }
+
+    void Encode(std::vector<uint8_t> &packet) const
+    {
+        const APRSStatus status = TryEncode(packet);
+
+        if (status != APRSStatus::OK)
+        {
+            throw EXCEPTION(std::string(to_string(status)) + " in packet from " + sender_callsign);
+        }
+    }
+
+    static APRSPacket Decode(const std::vector<uint8_t> &packet)
+    {
+        return Decode(AX25FrameView(packet.data(), packet.size()));
+    }
+
+    static APRSPacket Decode(const AX25FrameView &frame)
+    {
+        auto packet = TryDecode(frame);
+
+        if (!packet)
+        {
+            throw EXCEPTION(to_string(packet.error()));
+        }
+
+        return std::move(*packet);
+    }
+
+    // encodes into a caller-supplied buffer, reusing its storage
+    // the outcome is counted into metrics if given, each caller keeps its own so threads don't share counters
+    APRSStatus TryEncode(std::vector<uint8_t> &packet, Metrics *metrics = nullptr) const
+    {
+        const APRSStatus status = encode(packet);
+
+        if (metrics)
+        {
+            metrics->add(status == APRSStatus::OK ? Metrics::ENCODED : Metrics::CODEC_ERRORS);
+        }
+
+        return status;
+    }
+
+    static Expected<APRSPacket> TryDecode(const std::vector<uint8_t> &packet, Metrics *metrics = nullptr)
+    {
+        return TryDecode(AX25FrameView(packet.data(), packet.size()), metrics);
+    }
+
+    static Expected<APRSPacket> TryDecode(const AX25FrameView &frame, Metrics *metrics = nullptr)
+    {
+        auto packet = decode(frame);
+
+        if (metrics)
+        {
+            metrics->add(packet ? Metrics::DECODED : Metrics::CODEC_ERRORS);
+        }
+
+        return packet;
+    }
+
+    // checks the trailing 2-byte FCS of a raw frame
+    static bool CheckFCS(const uint8_t *frame, size_t size)
+    {
+        return CRC16::check(frame, size);
+    }
+
+  private:
+    APRSStatus encode(std::vector<uint8_t> &packet) const
+    {
+        packet.clear();
 
         // Field name   | FLAG | DEST   | SOURCE | DIGIS | CONTROL | PROTO | INFO   | FCS   | FLAG
         // Size (bytes) | 1    | 7      | 7      | 0-56  | 1       | 1     | 1-256  | 2     | 1
@@ -56,22 +137,40 @@ class APRSPacket
         packet.push_back(0b01110000 | 1);
 
         // Source Address
-        prepareCallsign(sender_callsign);
+        if (sender_callsign.size() > 6)
+        {
+            return APRSStatus::INVALID_CALLSIGN;
+        }
+
         packet.insert(packet.end(), std::begin(sender_callsign), std::end(sender_callsign));
+        packet.insert(packet.end(), 6 - sender_callsign.size(), ' ');
         packet.push_back(0b00110000 | (sender_ssid & 0x0F));
 
-        //packet.append(prepareCallsign("WIDE1"));
-        //packet.push_back(0b00110001); // 0b0HRRSSID (H - 'has been repeated' bit, RR - reserved '11', SSID - 0-15)
-
-        //packet.append(prepareCallsign("WIDE2"));
-        //packet.push_back(0b00110001); // 0b0HRRSSID (H - 'has been repeated' bit, RR - reserved '11', SSID - 0-15)
-
         // left shift the address bytes
         for (auto &byte : packet)
         {
             byte <<= 1;
         }
 
+        // Digipeater Addresses, already shifted
+        // 0b0HRRSSID (H - 'has been repeated' bit, RR - reserved '11', SSID - 0-15)
+        if (path.size() > AX25FrameView::max_digipeaters)
+        {
+            return APRSStatus::PATH_TOO_LONG;
+        }
+
+        for (const auto &hop : path)
+        {
+            AX25Address digipeater;
+            if (!AX25Address::Parse(hop, digipeater))
+            {
+                return APRSStatus::INVALID_PATH;
+            }
+
+            packet.resize(packet.size() + AX25Address::size);
+            digipeater.Write(&packet[packet.size() - AX25Address::size]);
+        }
+
         // the last byte's LSB set to '1' to indicate the end of the address fields
         packet.back() |= 0x01;
 
@@ -85,103 +184,53 @@ class APRSPacket
         packet.insert(packet.end(), std::begin(custom_data), std::end(custom_data));
 
         // Frame Check Sequence - CRC-16-CCITT (0xFFFF)
-        uint16_t crc = 0xFFFF;
-        for (uint16_t i = 0; i < packet.size(); i++)
-        {
-            crc = crc_ccitt_update(crc, packet[i]);
-        }
-
-        crc = ~crc;
+        uint16_t crc = CRC16::compute(packet.data(), packet.size());
         packet.push_back(crc & 0xFF);        // FCS is sent low-byte first
         packet.push_back((crc >> 8) & 0xFF); // and with the bits flipped
 
         // end flag
         //packet.push_back(0x7E);
-        return packet;
 
-        END();
+        return APRSStatus::OK;
     }
 
-    static APRSPacket Decode(const std::vector<uint8_t> &packet)
+    static Expected<APRSPacket> decode(const AX25FrameView &frame)
     {
-        BEGIN();
-        char dest_address[6] = {0};
-        char source_address[6] = {0};
-
-        for (size_t i = 0; i < 6; ++i)
+        if (!frame.IsValid())
         {
-            auto c = packet[i] >> 1;
-            if (c == ' ')
-            {
-                break;
-            }
-
-            dest_address[i] = c;
+            return APRSStatus::MALFORMED_FRAME;
         }
 
-        // 1 byte for ssid
-
-        for (size_t i = 0; i < 6; ++i)
+        if (!frame.HasValidFCS())
         {
-            auto c = packet[i + 7] >> 1;
-            if (c == ' ')
-            {
-                break;
-            }
-
-            source_address[i] = c;
+            return APRSStatus::BAD_FCS;
         }
 
-        size_t idx = 6 + 1 + 6;
-        uint8_t sender_ssid = (packet[idx] >> 1) & 0b00001111;
-
-        while ((packet[idx++] & 0b01) == 0)
-            ;
-
-        uint8_t control = packet[idx++];
-        uint8_t proto = packet[idx++];
-
-        std::string message(packet.begin() + idx, packet.end() - 2);
-
-        idx = packet.size() - 2;
-
-        uint16_t crc = packet[idx++] | packet[idx++] << 8;
+        std::vector<std::string> path;
+        path.reserve(frame.Digipeaters());
 
-        return APRSPacket(source_address, sender_ssid, message);
-        END();
-    }
-
-  private:
-    static void prepareCallsign(std::string &cs)
-    {
-        BEGIN();
-
-        if (cs.size() > 6)
+        for (size_t i = 0; i < frame.Digipeaters(); ++i)
         {
-            throw EXCEPTION("Callsign " + cs + " is longer than 6 symbols!");
-        }
+            const auto digipeater = frame.Digipeater(i);
+            path.push_back(std::string(digipeater.callsign()));
 
-        cs.append(6 - cs.size(), ' ');
-
-        END();
-    }
-
-    static uint16_t crc_ccitt_update(uint16_t crc, uint8_t data)
-    {
-        BEGIN();
-
-        data ^= crc & 0xff;
-        data ^= data << 4;
+            if (digipeater.ssid)
+            {
+                path.back() += '-' + std::to_string(digipeater.ssid);
+            }
 
-        return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+            if (digipeater.h)
+            {
+                path.back() += '*';
+            }
+        }
 
-        END();
+        const auto source = frame.Source();
+        return APRSPacket(std::string(source.callsign()), source.ssid, std::string(frame.Info()), path);
     }
 
     static std::string timestr()
     {
-        BEGIN();
-
         time_t rawtime;
         struct tm *timeinfo;
         char buffer[10];
@@ -191,7 +240,5 @@ class APRSPacket
 
         strftime(buffer, sizeof(buffer), "%H%M%Sh", timeinfo);
         return buffer;
-
-        END();
     }
 };
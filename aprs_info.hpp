@@ -0,0 +1,691 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "ax25.hpp"
+
+// Position report, shared by plain positions, Mic-E and objects
+struct APRSPosition
+{
+    // degrees, north and east positive
+    double latitude = 0;
+    double longitude = 0;
+
+    char symbol_table = 0;
+    char symbol = 0;
+
+    bool compressed = false;
+
+    bool has_course = false;
+    uint16_t course = 0; // degrees, 0 = unknown
+    uint16_t speed = 0;  // knots
+
+    bool has_altitude = false;
+    int32_t altitude = 0; // feet
+};
+
+struct APRSMessage
+{
+    std::string_view addressee;
+    std::string_view text;
+
+    // message number after '{', or the number being acked/rejected
+    std::string_view id;
+
+    bool ack = false;
+    bool rej = false;
+};
+
+struct APRSTelemetry
+{
+    // sequence number, or "MIC"
+    std::string_view sequence;
+
+    float analog[5] = { };
+    uint8_t analog_count = 0;
+
+    // bit 7 is the first digital channel
+    uint8_t digital = 0;
+};
+
+// Decoded APRS information field
+// All string_views point into the frame, nothing is copied or allocated
+struct APRSInfo
+{
+    enum Type : uint8_t
+    {
+        UNKNOWN,
+        POSITION,
+        MIC_E,
+        MESSAGE,
+        STATUS,
+        OBJECT,
+        TELEMETRY,
+    };
+
+    Type type = UNKNOWN;
+
+    // data type identifier, the first byte of the info field
+    char identifier = 0;
+
+    // the station can receive messages
+    bool messaging = false;
+
+    // "DDHHMMz", "DDHHMM/" or "HHMMSSh", empty if there is none
+    std::string_view timestamp;
+
+    // POSITION, MIC_E and OBJECT
+    APRSPosition position;
+
+    // MESSAGE
+    APRSMessage message;
+
+    // OBJECT
+    std::string_view object_name;
+    bool object_live = false;
+
+    // TELEMETRY
+    APRSTelemetry telemetry;
+
+    // Mic-E message code: 0-6 for M0-M6 (or C0-C6 when custom), 7 is emergency
+    uint8_t mic_e_message = 0;
+    bool mic_e_custom = false;
+
+    // free text after the structured part, the status text for STATUS
+    std::string_view comment;
+
+    // parses the info field of a frame, Mic-E needs the destination address too
+    static bool Parse(const AX25FrameView &frame, APRSInfo &out)
+    {
+        const auto destination = frame.Destination();
+        return Parse(frame.Info(), destination.callsign(), out);
+    }
+
+    // returns false (and type UNKNOWN) for unsupported or malformed fields
+    static bool Parse(std::string_view info, std::string_view destination, APRSInfo &out)
+    {
+        out = APRSInfo();
+
+        if (info.empty())
+        {
+            return false;
+        }
+
+        out.identifier = info[0];
+
+        switch (info[0])
+        {
+        case '!':
+        case '=':
+            out.messaging = info[0] == '=';
+            return parse_position_report(info.substr(1), out);
+
+        case '/':
+        case '@':
+            out.messaging = info[0] == '@';
+            if (info.size() < 8)
+            {
+                return fail(out);
+            }
+
+            out.timestamp = info.substr(1, 7);
+            return parse_position_report(info.substr(8), out);
+
+        case '`':
+        case '\'':
+        case 0x1C:
+        case 0x1D:
+            return parse_mic_e(info, destination, out);
+
+        case ':':
+            return parse_message(info, out);
+
+        case '>':
+            return parse_status(info, out);
+
+        case ';':
+            return parse_object(info, out);
+
+        case 'T':
+            return parse_telemetry(info, out);
+
+        default:
+            return false;
+        }
+    }
+
+  private:
+    static bool fail(APRSInfo &out)
+    {
+        out.type = UNKNOWN;
+        return false;
+    }
+
+    static bool digit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // fixed-width decimal digits, spaces (position ambiguity) count as 0
+    static bool digits(std::string_view s, size_t pos, size_t count, int &value)
+    {
+        value = 0;
+
+        for (size_t i = pos; i < pos + count; ++i)
+        {
+            const char c = s[i];
+
+            if (!digit(c) && c != ' ')
+            {
+                return false;
+            }
+
+            value = value * 10 + (c == ' ' ? 0 : c - '0');
+        }
+
+        return true;
+    }
+
+    // up to 4 base-91 digits
+    static uint32_t base91(std::string_view s)
+    {
+        uint32_t value = 0;
+        for (char c : s)
+        {
+            value = value * 91 + (uint8_t(c) - 33);
+        }
+        return value;
+    }
+
+    // "[-]123[.45]", consumes as much as matches
+    static bool decimal(std::string_view &s, float &value)
+    {
+        size_t i = 0;
+        const bool negative = i < s.size() && s[i] == '-';
+        i += negative;
+
+        const size_t begin = i;
+        float result = 0;
+
+        for (; i < s.size() && digit(s[i]); ++i)
+        {
+            result = result * 10 + (s[i] - '0');
+        }
+
+        if (i < s.size() && s[i] == '.')
+        {
+            float scale = 0.1f;
+            for (++i; i < s.size() && digit(s[i]); ++i, scale *= 0.1f)
+            {
+                result += (s[i] - '0') * scale;
+            }
+        }
+
+        if (i == begin)
+        {
+            return false;
+        }
+
+        value = negative ? -result : result;
+        s.remove_prefix(i);
+        return true;
+    }
+
+    // "DDMM.hhN/DDDMM.hhW$" or the 13 byte compressed form, followed by the comment
+    static bool parse_position_report(std::string_view data, APRSInfo &out)
+    {
+        size_t used;
+        if (!parse_position(data, out.position, used))
+        {
+            return fail(out);
+        }
+
+        out.type = POSITION;
+        out.comment = data.substr(used);
+
+        if (!out.position.compressed)
+        {
+            parse_extensions(out);
+        }
+
+        parse_altitude(out);
+        return true;
+    }
+
+    static bool parse_position(std::string_view data, APRSPosition &pos, size_t &used)
+    {
+        if (data.empty())
+        {
+            return false;
+        }
+
+        // compressed positions start with the symbol table instead of a latitude digit
+        if (!digit(data[0]) && data[0] != ' ')
+        {
+            return parse_compressed(data, pos, used);
+        }
+
+        if (data.size() < 19 || data[4] != '.' || data[14] != '.')
+        {
+            return false;
+        }
+
+        int deg, min, hundredths;
+
+        if (!digits(data, 0, 2, deg) || !digits(data, 2, 2, min) || !digits(data, 5, 2, hundredths) ||
+            (data[7] != 'N' && data[7] != 'S'))
+        {
+            return false;
+        }
+
+        pos.latitude = deg + (min + hundredths / 100.0) / 60;
+        if (data[7] == 'S')
+        {
+            pos.latitude = -pos.latitude;
+        }
+
+        pos.symbol_table = data[8];
+
+        if (!digits(data, 9, 3, deg) || !digits(data, 12, 2, min) || !digits(data, 15, 2, hundredths) ||
+            (data[17] != 'E' && data[17] != 'W'))
+        {
+            return false;
+        }
+
+        pos.longitude = deg + (min + hundredths / 100.0) / 60;
+        if (data[17] == 'W')
+        {
+            pos.longitude = -pos.longitude;
+        }
+
+        pos.symbol = data[18];
+
+        used = 19;
+        return pos.latitude <= 90 && pos.longitude <= 180;
+    }
+
+    // "/YYYYXXXX$csT": table, base-91 lat/lon, symbol, course/speed or altitude, type byte
+    static bool parse_compressed(std::string_view data, APRSPosition &pos, size_t &used)
+    {
+        if (data.size() < 13)
+        {
+            return false;
+        }
+
+        for (size_t i = 1; i < 9; ++i)
+        {
+            if (data[i] < '!' || data[i] > '{')
+            {
+                return false;
+            }
+        }
+
+        pos.compressed = true;
+        pos.symbol_table = data[0];
+        pos.latitude = 90 - base91(data.substr(1, 4)) / 380926.0;
+        pos.longitude = -180 + base91(data.substr(5, 4)) / 190463.0;
+        pos.symbol = data[9];
+
+        const uint8_t c = data[10];
+        const uint8_t s = data[11];
+        const uint8_t t = data[12] - 33;
+
+        if (c != ' ')
+        {
+            if ((t & 0x18) == 0x10)
+            {
+                pos.has_altitude = true;
+                pos.altitude = int32_t(pow(1.002, (c - 33) * 91 + (s - 33)));
+            }
+            else if (c >= '!' && c <= 'z')
+            {
+                pos.has_course = true;
+                pos.course = (c - 33) * 4;
+                pos.speed = uint16_t(pow(1.08, s - 33) - 1 + 0.5);
+            }
+        }
+
+        used = 13;
+        return true;
+    }
+
+    // integer power, the exponents here are small and non-negative
+    static double pow(double base, unsigned exponent)
+    {
+        double result = 1;
+        for (; exponent; exponent >>= 1, base *= base)
+        {
+            if (exponent & 1)
+            {
+                result *= base;
+            }
+        }
+        return result;
+    }
+
+    // "ddd/sss" course and speed right after an uncompressed position
+    static void parse_extensions(APRSInfo &out)
+    {
+        const auto &c = out.comment;
+        int course, speed;
+
+        if (c.size() >= 7 && c[3] == '/' && digits(c, 0, 3, course) && digits(c, 4, 3, speed))
+        {
+            out.position.has_course = true;
+            out.position.course = course;
+            out.position.speed = speed;
+            out.comment.remove_prefix(7);
+        }
+    }
+
+    // "/A=nnnnnn" anywhere in the comment, in feet
+    static void parse_altitude(APRSInfo &out)
+    {
+        const size_t at = out.comment.find("/A=");
+
+        if (at == std::string_view::npos || at + 9 > out.comment.size())
+        {
+            return;
+        }
+
+        const bool negative = out.comment[at + 3] == '-';
+        int value;
+
+        if (digits(out.comment, at + 3 + negative, 6 - negative, value))
+        {
+            out.position.has_altitude = true;
+            out.position.altitude = negative ? -value : value;
+        }
+    }
+
+    // position and message bits in the destination, course/speed in the info field
+    static bool parse_mic_e(std::string_view info, std::string_view destination, APRSInfo &out)
+    {
+        if (info.size() < 9 || destination.size() != 6)
+        {
+            return fail(out);
+        }
+
+        int lat = 0;
+        uint8_t flags = 0;
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            const char c = destination[i];
+            int d;
+
+            // standard message bits: P-Z, custom: A-K, L and 0-9 are zero
+            if (c >= '0' && c <= '9')
+            {
+                d = c - '0';
+            }
+            else if (c >= 'A' && c <= 'J')
+            {
+                d = c - 'A';
+                out.mic_e_custom = true;
+            }
+            else if (c == 'K')
+            {
+                d = 0;
+                out.mic_e_custom = true;
+            }
+            else if (c == 'L')
+            {
+                d = 0;
+            }
+            else if (c >= 'P' && c <= 'Y')
+            {
+                d = c - 'P';
+            }
+            else if (c == 'Z')
+            {
+                d = 0;
+            }
+            else
+            {
+                return fail(out);
+            }
+
+            lat = lat * 10 + d;
+
+            // message bits for the first three, north / +100 / west for the rest
+            const bool set = c >= 'P' || (i < 3 && c >= 'A' && c <= 'K');
+            flags |= set << (5 - i);
+        }
+
+        out.mic_e_message = 7 - (flags >> 3);
+
+        auto &pos = out.position;
+        pos.latitude = lat / 10000 + (lat % 10000) / 100.0 / 60;
+        if (!(flags & 0b100))
+        {
+            pos.latitude = -pos.latitude;
+        }
+
+        int deg = uint8_t(info[1]) - 28;
+        if (flags & 0b010)
+        {
+            deg += 100;
+        }
+        if (deg >= 180 && deg <= 189)
+        {
+            deg -= 80;
+        }
+        else if (deg >= 190 && deg <= 199)
+        {
+            deg -= 190;
+        }
+
+        int min = uint8_t(info[2]) - 28;
+        if (min >= 60)
+        {
+            min -= 60;
+        }
+
+        const int hundredths = uint8_t(info[3]) - 28;
+
+        pos.longitude = deg + (min + hundredths / 100.0) / 60;
+        if (flags & 0b001)
+        {
+            pos.longitude = -pos.longitude;
+        }
+
+        const int sp = uint8_t(info[4]) - 28;
+        const int dc = uint8_t(info[5]) - 28;
+        const int se = uint8_t(info[6]) - 28;
+
+        int speed = sp * 10 + dc / 10;
+        int course = (dc % 10) * 100 + se;
+        if (speed >= 800)
+        {
+            speed -= 800;
+        }
+        if (course >= 400)
+        {
+            course -= 400;
+        }
+
+        pos.has_course = true;
+        pos.speed = speed;
+        pos.course = course;
+        pos.symbol = info[7];
+        pos.symbol_table = info[8];
+
+        out.type = MIC_E;
+        out.comment = info.substr(9);
+
+        // optional "xxx}" altitude in meters above -10 km, possibly after a radio type byte
+        for (size_t at : {size_t(3), size_t(4)})
+        {
+            if (out.comment.size() > at && out.comment[at] == '}')
+            {
+                const double meters = double(base91(out.comment.substr(at - 3, 3))) - 10000;
+                pos.has_altitude = true;
+                pos.altitude = int32_t(meters * 3.28084);
+                out.comment.remove_prefix(at + 1);
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    // ":ADDRESSEE:text{id", ":ADDRESSEE:ackid" or ":ADDRESSEE:rejid"
+    static bool parse_message(std::string_view info, APRSInfo &out)
+    {
+        if (info.size() < 11 || info[10] != ':')
+        {
+            return fail(out);
+        }
+
+        auto &msg = out.message;
+
+        msg.addressee = info.substr(1, 9);
+        while (!msg.addressee.empty() && msg.addressee.back() == ' ')
+        {
+            msg.addressee.remove_suffix(1);
+        }
+
+        std::string_view text = info.substr(11);
+
+        if (text.size() > 3 && (text.substr(0, 3) == "ack" || text.substr(0, 3) == "rej") &&
+            text.find(' ') == std::string_view::npos)
+        {
+            msg.ack = text[0] == 'a';
+            msg.rej = text[0] == 'r';
+            msg.id = text.substr(3);
+        }
+        else
+        {
+            const size_t brace = text.rfind('{');
+            if (brace != std::string_view::npos)
+            {
+                msg.id = text.substr(brace + 1);
+                text = text.substr(0, brace);
+            }
+
+            msg.text = text;
+        }
+
+        out.type = MESSAGE;
+        return true;
+    }
+
+    // ">[DDHHMMz]text"
+    static bool parse_status(std::string_view info, APRSInfo &out)
+    {
+        std::string_view text = info.substr(1);
+
+        int value;
+        if (text.size() >= 7 && text[6] == 'z' && digits(text, 0, 6, value))
+        {
+            out.timestamp = text.substr(0, 7);
+            text.remove_prefix(7);
+        }
+
+        out.type = STATUS;
+        out.comment = text;
+        return true;
+    }
+
+    // ";NAME_____*DDHHMMz<position><comment>", '_' instead of '*' for a killed object
+    static bool parse_object(std::string_view info, APRSInfo &out)
+    {
+        if (info.size() < 18 || (info[10] != '*' && info[10] != '_'))
+        {
+            return fail(out);
+        }
+
+        out.object_name = info.substr(1, 9);
+        while (!out.object_name.empty() && out.object_name.back() == ' ')
+        {
+            out.object_name.remove_suffix(1);
+        }
+
+        out.object_live = info[10] == '*';
+        out.timestamp = info.substr(11, 7);
+
+        if (!parse_position_report(info.substr(18), out))
+        {
+            return false;
+        }
+
+        out.type = OBJECT;
+        return true;
+    }
+
+    // "T#sss,a1,a2,a3,a4,a5,bbbbbbbb[comment]"
+    static bool parse_telemetry(std::string_view info, APRSInfo &out)
+    {
+        if (info.size() < 3 || info[1] != '#')
+        {
+            return fail(out);
+        }
+
+        std::string_view rest = info.substr(2);
+        auto &t = out.telemetry;
+
+        // "T#MIC" may or may not be followed by a comma
+        if (rest.substr(0, 3) == "MIC")
+        {
+            t.sequence = rest.substr(0, 3);
+            rest.remove_prefix(rest.size() > 3 && rest[3] == ',' ? 4 : 3);
+        }
+        else
+        {
+            const size_t comma = rest.find(',');
+            if (comma == std::string_view::npos)
+            {
+                return fail(out);
+            }
+
+            t.sequence = rest.substr(0, comma);
+            rest.remove_prefix(comma + 1);
+        }
+
+        for (; t.analog_count < 5; ++t.analog_count)
+        {
+            if (!decimal(rest, t.analog[t.analog_count]))
+            {
+                break;
+            }
+
+            if (rest.empty() || rest[0] != ',')
+            {
+                ++t.analog_count;
+                break;
+            }
+
+            rest.remove_prefix(1);
+        }
+
+        if (t.analog_count == 0)
+        {
+            return fail(out);
+        }
+
+        // the digital bits only follow all five analog values
+        if (t.analog_count == 5 && rest.size() >= 8)
+        {
+            bool bits = true;
+            uint8_t digital = 0;
+
+            for (size_t i = 0; i < 8; ++i)
+            {
+                bits &= rest[i] == '0' || rest[i] == '1';
+                digital = digital << 1 | (rest[i] == '1');
+            }
+
+            if (bits)
+            {
+                t.digital = digital;
+                rest.remove_prefix(8);
+            }
+        }
+
+        out.type = TELEMETRY;
+        out.comment = rest;
+        return true;
+    }
+};
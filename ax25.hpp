@@ -0,0 +1,273 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "crc.hpp"
+
+// One AX.25 address as found in the header: 6 shifted ASCII characters plus the SSID byte
+// Decoded into a small inline buffer, so it never allocates
+struct AX25Address
+{
+    static const size_t size = 7;
+    static const size_t callsign_size = 6;
+
+    char text[callsign_size + 1] = { };
+    uint8_t length = 0;
+    uint8_t ssid = 0;
+
+    // H (has-been-repeated) bit for digipeaters, C (command/response) bit for destination and source
+    bool h = false;
+
+    // extension bit, set on the last address of the header
+    bool last = false;
+
+    AX25Address() = default;
+
+    explicit AX25Address(const uint8_t *raw)
+    {
+        for (size_t i = 0; i < callsign_size; ++i)
+        {
+            const char c = raw[i] >> 1;
+            if (c == ' ')
+            {
+                break;
+            }
+
+            text[length++] = c;
+        }
+
+        ssid = (raw[6] >> 1) & 0x0F;
+        h = raw[6] & 0x80;
+        last = raw[6] & 0x01;
+    }
+
+    // parses "CALL", "CALL-N" or "CALL-N*", where * marks a repeated digipeater
+    static bool Parse(std::string_view address, AX25Address &out)
+    {
+        out = AX25Address();
+
+        if (!address.empty() && address.back() == '*')
+        {
+            out.h = true;
+            address.remove_suffix(1);
+        }
+
+        const size_t dash = address.find('-');
+        const std::string_view callsign = address.substr(0, dash);
+
+        if (callsign.empty() || callsign.size() > callsign_size)
+        {
+            return false;
+        }
+
+        for (char c : callsign)
+        {
+            if (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9'))
+            {
+                return false;
+            }
+
+            out.text[out.length++] = c;
+        }
+
+        if (dash == std::string_view::npos)
+        {
+            return true;
+        }
+
+        const std::string_view ssid = address.substr(dash + 1);
+
+        if (ssid.empty() || ssid.size() > 2)
+        {
+            return false;
+        }
+
+        unsigned value = 0;
+        for (char c : ssid)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+
+            value = value * 10 + (c - '0');
+        }
+
+        out.ssid = value;
+        return value <= 15;
+    }
+
+    // writes the 7 header bytes, keeping the reserved bits set as AX.25 requires
+    void Write(uint8_t *raw) const
+    {
+        for (size_t i = 0; i < callsign_size; ++i)
+        {
+            raw[i] = (i < length ? text[i] : ' ') << 1;
+        }
+
+        raw[6] = (h ? 0x80 : 0) | 0x60 | (ssid << 1) | (last ? 0x01 : 0);
+    }
+
+    // callsign without the SSID or trailing padding
+    std::string_view callsign() const
+    {
+        return std::string_view(text, length);
+    }
+
+    bool Matches(std::string_view other, uint8_t other_ssid) const
+    {
+        return callsign() == other && ssid == other_ssid;
+    }
+};
+
+// Non-owning view over a raw AX.25 frame (addresses, control, PID, info and FCS, no flags)
+// Only the bounds of the header are worked out up front, the fields are decoded on access
+// The viewed bytes must outlive the view
+class AX25FrameView
+{
+  public:
+    static const size_t max_digipeaters = 8;
+
+    // destination, source, control and FCS
+    static const size_t min_size = 2 * AX25Address::size + 1 + 2;
+
+    AX25FrameView(const uint8_t *frame, size_t size)
+        : frame(frame),
+          frame_size(size)
+    {
+        parse();
+    }
+
+    // false if the header is truncated or malformed, nothing else may be called then
+    bool IsValid() const
+    {
+        return valid;
+    }
+
+    bool HasValidFCS() const
+    {
+        return CRC16::check(frame, frame_size);
+    }
+
+    AX25Address Destination() const
+    {
+        return AX25Address(frame);
+    }
+
+    AX25Address Source() const
+    {
+        return AX25Address(frame + AX25Address::size);
+    }
+
+    size_t Digipeaters() const
+    {
+        return digipeaters;
+    }
+
+    AX25Address Digipeater(size_t i) const
+    {
+        return AX25Address(frame + DigipeaterOffset(i));
+    }
+
+    // where the i-th digipeater address starts in the frame, for rewriting it in place
+    static size_t DigipeaterOffset(size_t i)
+    {
+        return (2 + i) * AX25Address::size;
+    }
+
+    uint8_t Control() const
+    {
+        return frame[header_size];
+    }
+
+    // only I and UI frames carry a PID, 0 otherwise
+    bool HasPID() const
+    {
+        return has_pid;
+    }
+
+    uint8_t PID() const
+    {
+        return has_pid ? frame[header_size + 1] : 0;
+    }
+
+    // UI frame with no layer 3 protocol, i.e. an APRS packet
+    bool IsUI() const
+    {
+        return (Control() & 0xEF) == 0x03;
+    }
+
+    std::string_view Info() const
+    {
+        const size_t begin = header_size + 1 + has_pid;
+        return std::string_view(reinterpret_cast<const char *>(frame) + begin, frame_size - 2 - begin);
+    }
+
+    const uint8_t *Data() const
+    {
+        return frame;
+    }
+
+    size_t Size() const
+    {
+        return frame_size;
+    }
+
+  private:
+    void parse()
+    {
+        if (frame_size < min_size)
+        {
+            return;
+        }
+
+        // the extension bit ends the address field, at most 2 + 8 addresses
+        size_t addresses = 0;
+
+        while (true)
+        {
+            const size_t end = (addresses + 1) * AX25Address::size;
+
+            if (addresses == 2 + max_digipeaters || end > frame_size)
+            {
+                return;
+            }
+
+            ++addresses;
+
+            if (frame[end - 1] & 0x01)
+            {
+                break;
+            }
+        }
+
+        if (addresses < 2)
+        {
+            return;
+        }
+
+        header_size = addresses * AX25Address::size;
+        digipeaters = addresses - 2;
+
+        // a frame ending on an address boundary has no control byte to read
+        if (header_size + 1 + 2 > frame_size)
+        {
+            return;
+        }
+
+        // I frames have bit 0 of control clear, UI is 0x03 with the P/F bit masked out
+        const uint8_t control = frame[header_size];
+        has_pid = (control & 0x01) == 0 || (control & 0xEF) == 0x03;
+
+        valid = header_size + 1 + has_pid + 2 <= frame_size;
+    }
+
+    const uint8_t *frame;
+    size_t frame_size;
+
+    size_t header_size = 0;
+    size_t digipeaters = 0;
+    bool has_pid = false;
+    bool valid = false;
+};
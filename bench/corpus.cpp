@@ -0,0 +1,40 @@
+// Writes a seeded synthetic corpus as an 8-bit WAV, to feed the CLI or train a PGO build
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -I.. corpus.cpp -o corpus && ./corpus out.wav [frames] [seed] [noise] [twist dB] [rate]
+// the corpus is synthesized at the decoders' rate and resampled to rate, if given
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../resampler.hpp"
+#include "../wav.hpp"
+#include "corpus.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <out.wav> [frames] [seed] [noise] [twist dB] [rate]" << std::endl;
+        return 1;
+    }
+
+    ChannelModel model;
+    const size_t count = argc > 2 ? std::atoi(argv[2]) : 200;
+    const uint32_t seed = argc > 3 ? std::atoi(argv[3]) : 1;
+    model.noise = argc > 4 ? std::atof(argv[4]) : 12;
+    model.twist = argc > 5 ? std::atof(argv[5]) : 0;
+    const size_t rate = argc > 6 ? std::atoi(argv[6]) : AFSK::sample_rate;
+
+    const Corpus corpus(model, count, seed);
+
+    Resampler resampler(AFSK::sample_rate, rate);
+    std::vector<uint8_t> samples(resampler.max_output(corpus.samples.size()));
+    samples.resize(resampler.process(corpus.samples.data(), corpus.samples.size(), samples.data()));
+
+    WAVWriter ww(argv[1], rate);
+    ww.put(samples);
+    ww.close();
+
+    std::cout << corpus.frames.size() << " frames, " << samples.size() << " samples at " << rate << " Hz" << std::endl;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../afsk.hpp"
+
+// Synthetic channel conditions, applied to AFSK::Encoder output
+struct ChannelModel
+{
+    // standard deviation of white noise, in 8-bit sample units (the signal peaks at +-amplitude)
+    double noise = 0;
+
+    // dB the space tone sits below the mark tone, > 0 is de-emphasis, < 0 is pre-emphasis
+    double twist = 0;
+
+    // transmitter clock error in ppm, shifts the baud rate and the tones together, > 0 is a fast clock
+    double skew = 0;
+};
+
+// Frames encoded back to back, each after a random gap and a random fraction of a sample of delay, so neither the
+// bit timing nor the carrier phase is tied to the sample grid
+// Everything is derived from the seed (mt19937 plus Box-Muller), so a corpus is identical on every platform
+struct Corpus
+{
+    static const int amplitude = 64;
+
+    std::vector<uint8_t> samples;
+
+    // encoded frames, FCS included, and where each one's audio starts and ends
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<size_t> begin, end;
+
+    Corpus(const ChannelModel &model, size_t count, uint32_t seed)
+        : rng(seed)
+    {
+        // a fast transmitter fits a baud into fewer of the receiver's samples
+        const size_t rate = std::lround(AFSK::sample_rate * (1 - model.skew * 1e-6));
+        std::vector<float> audio;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            frames.push_back(APRSPacket("BENCH", i % 16, ">corpus frame " + std::to_string(i), {"WIDE1-1"}).Encode());
+
+            // up to two bauds of silence plus a fixed gap
+            audio.resize(audio.size() + 64 + rng() % (2 * AFSK::Decoder::window_size), 0.0f);
+            begin.push_back(audio.size());
+
+            auto tone = AFSK::Encoder::Encode<float>(frames.back(), 4, 4, rate);
+            delay(tone, (rng() >> 8) / 16777216.0);
+            audio.insert(audio.end(), tone.begin(), tone.end());
+            end.push_back(audio.size());
+        }
+
+        tilt(audio, model.twist);
+
+        float peak = 0;
+        for (float x : audio)
+        {
+            peak = std::max(peak, std::abs(x));
+        }
+
+        samples.resize(audio.size());
+        for (size_t i = 0; i < audio.size(); ++i)
+        {
+            const double x = 128 + amplitude * audio[i] / peak + model.noise * gauss();
+            samples[i] = std::clamp<long>(std::lround(x), 0, 255);
+        }
+    }
+
+  private:
+    double gauss()
+    {
+        const double u = (rng() + 1.0) / 4294967296.0;
+        const double v = rng() / 4294967296.0;
+        return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+    }
+
+    // fractional delay of 0 to 1 sample, a Blackman-windowed sinc flat to well past the space tone
+    // only the preamble and tail bytes are near the edges, so the length stays the same
+    static void delay(std::vector<float> &audio, double fraction)
+    {
+        const int half = 8;
+        float h[2 * half];
+        double sum = 0;
+
+        for (int k = 0; k < 2 * half; ++k)
+        {
+            const double t = k - half + 1 - fraction;
+            const double w = 0.42 + 0.5 * std::cos(M_PI * t / half) + 0.08 * std::cos(2 * M_PI * t / half);
+            h[k] = w * (t == 0 ? 1 : std::sin(M_PI * t) / (M_PI * t));
+            sum += h[k];
+        }
+
+        const std::vector<float> x = audio;
+        for (size_t n = 0; n < x.size(); ++n)
+        {
+            double y = 0;
+            for (int k = 0; k < 2 * half; ++k)
+            {
+                const long i = long(n) + half - 1 - k;
+                y += i >= 0 && i < long(x.size()) ? h[k] * x[i] : 0;
+            }
+
+            audio[n] = y / sum;
+        }
+    }
+
+    // mark over space level of a filter with squared response h2, in dB
+    template <typename Response>
+    static double twist_of(Response &&h2)
+    {
+        const double mark = 2 * M_PI * AFSK::mark_freq / AFSK::sample_rate;
+        const double space = 2 * M_PI * AFSK::space_freq / AFSK::sample_rate;
+        return 10 * std::log10(h2(mark) / h2(space));
+    }
+
+    // cascade of first-order sections: one-pole lowpasses for de-emphasis, first differences for pre-emphasis
+    // a single difference can't tilt more than ~4.7 dB between the tones, so every section takes at most 4 dB
+    static void tilt(std::vector<float> &audio, double twist)
+    {
+        const int sections = std::ceil(std::abs(twist) / 4);
+
+        for (int s = 0; s < sections; ++s)
+        {
+            const double target = twist / sections;
+
+            // y += a * (x - y)
+            auto lowpass = [](double a) {
+                return [a](double w) { return a * a / (1 - 2 * (1 - a) * std::cos(w) + (1 - a) * (1 - a)); };
+            };
+
+            // y = x - b * x[-1]
+            auto difference = [](double b) {
+                return [b](double w) { return 1 - 2 * b * std::cos(w) + b * b; };
+            };
+
+            // both tilt monotonically in their coefficient, so bisect for it
+            double lo = 0, hi = 1;
+            for (int i = 0; i < 60; ++i)
+            {
+                const double mid = (lo + hi) / 2;
+                const bool more = target > 0 ? twist_of(lowpass(1 - mid)) < target : twist_of(difference(mid)) > target;
+                (more ? lo : hi) = mid;
+            }
+
+            double y = 0, previous = 0;
+            for (auto &x : audio)
+            {
+                if (target > 0)
+                {
+                    y += (1 - lo) * (x - y);
+                }
+                else
+                {
+                    y = x - lo * previous;
+                    previous = x;
+                }
+
+                x = y;
+            }
+        }
+    }
+
+    std::mt19937 rng;
+};
@@ -0,0 +1,117 @@
+// Discriminator microbenchmark: by-value fft2 (as it used to be) vs in-place fft2 vs batch kernels vs sliding correlator
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -I.. correlator.cpp -o correlator && ./correlator [seconds of audio]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../afsk.hpp"
+
+// the old signature: copies the whole recording on every call
+static int fft2_by_value(std::vector<uint8_t> data, int idx)
+{
+    return AFSK::Decoder::fft2(data.data() + idx);
+}
+
+template <typename F>
+static void run(const std::string &name, size_t samples, F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    volatile long sink = f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+
+    std::cout << name << ": " << samples / elapsed.count() << " samples/s ("
+              << samples / elapsed.count() / AFSK::sample_rate << "x real time)" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t seconds = argc > 1 ? std::atoi(argv[1]) : 60;
+
+    // fill the requested duration with back-to-back packets
+    std::vector<uint8_t> samples;
+    auto packet = APRSPacket("BENCH", 1, ">correlator benchmark").Encode();
+    auto frame = AFSK::Encoder::Encode(packet, 4, 4);
+
+    while (samples.size() < seconds * AFSK::sample_rate)
+    {
+        samples.insert(samples.end(), frame.begin(), frame.end());
+    }
+
+    const size_t window = AFSK::Decoder::window_size;
+
+    // quadratic, so only a slice of the input is used
+    const size_t legacy_samples = std::min(samples.size(), size_t(AFSK::sample_rate * 2));
+    run("fft2 by value", legacy_samples, [&] {
+        long sum = 0;
+        for (size_t i = 0; i + window <= legacy_samples; i += window)
+        {
+            sum += fft2_by_value(samples, i) > 0;
+        }
+        return sum;
+    });
+
+    run("fft2 in place", samples.size(), [&] {
+        long sum = 0;
+        for (size_t i = 0; i + window <= samples.size(); i += window)
+        {
+            sum += AFSK::Decoder::fft2(samples.data() + i) > 0;
+        }
+        return sum;
+    });
+
+    auto kernel = [&](Discriminator::kernel k) {
+        return [&, k] {
+            std::vector<int> out(4096);
+            long sum = 0;
+            for (size_t i = 0; i + window <= samples.size(); i += out.size() * window)
+            {
+                size_t n = std::min(out.size(), (samples.size() - i) / window);
+                k(samples.data() + i, window, n, out.data());
+                sum += out[n - 1] > 0;
+            }
+            return sum;
+        };
+    };
+
+    run("scalar kernel", samples.size(), kernel(Discriminator::scalar));
+#if DISCRIMINATOR_X86
+    run("sse2 kernel", samples.size(), kernel(Discriminator::sse2));
+    if (__builtin_cpu_supports("avx2"))
+    {
+        run("avx2 kernel", samples.size(), kernel(Discriminator::avx2));
+    }
+#elif DISCRIMINATOR_NEON
+    run("neon kernel", samples.size(), kernel(Discriminator::neon));
+#endif
+
+    run("sliding correlator (every sample)", samples.size(), [&] {
+        AFSK::Decoder::Correlator correlator;
+        std::vector<int> out(4096);
+        long sum = 0;
+        for (size_t i = 0; i < samples.size(); i += out.size())
+        {
+            size_t n = std::min(out.size(), samples.size() - i);
+            correlator.process(samples.data() + i, n, out.data());
+            sum += out[n - 1] > 0;
+        }
+        return sum;
+    });
+
+    run("stream decoder", samples.size(), [&] {
+        AFSK::Decoder::Stream stream([](const std::vector<uint8_t> &) {});
+        stream.feed(samples);
+        return long(stream.frames());
+    });
+
+    run("pll stream decoder", samples.size(), [&] {
+        AFSK::Decoder::PLLStream stream([](const std::vector<uint8_t> &) {});
+        stream.feed(samples);
+        return long(stream.frames());
+    });
+}
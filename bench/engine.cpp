@@ -0,0 +1,62 @@
+// Multi-channel engine scaling: the same channels decoded with 1, 2, 4, ... worker threads
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -pthread -I.. engine.cpp -o engine && ./engine [channels] [seconds of audio per channel]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../afsk.hpp"
+#include "../engine.hpp"
+
+int main(int argc, char *argv[])
+{
+    const size_t channels = argc > 1 ? std::atoi(argv[1]) : 8;
+    const size_t seconds = argc > 2 ? std::atoi(argv[2]) : 30;
+
+    std::vector<uint8_t> samples;
+    auto packet = APRSPacket("BENCH", 1, ">engine benchmark").Encode();
+    auto frame = AFSK::Encoder::Encode(packet, 4, 4);
+
+    while (samples.size() < seconds * AFSK::sample_rate)
+    {
+        samples.insert(samples.end(), frame.begin(), frame.end());
+    }
+
+    const size_t block = 4096;
+    double single = 0;
+
+    for (size_t threads = 1; threads <= std::min<size_t>(channels, std::thread::hardware_concurrency()); threads *= 2)
+    {
+        size_t frames = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        {
+            DecoderEngine engine(channels, AFSK::sample_rate, threads);
+            auto count = [&](const DecoderEngine::frame &) { ++frames; };
+
+            for (size_t i = 0; i < samples.size(); i += block)
+            {
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    engine.feed(c, samples.data() + i, std::min(block, samples.size() - i));
+                }
+
+                engine.poll(count);
+            }
+
+            engine.finish();
+            engine.poll(count);
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double rate = channels * samples.size() / elapsed.count();
+        single = single ? single : rate;
+
+        std::cout << threads << " threads: " << rate << " samples/s (" << rate / AFSK::sample_rate << "x real time, "
+                  << rate / single << "x one thread), " << frames << " frames" << std::endl;
+    }
+}
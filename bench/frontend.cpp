@@ -0,0 +1,91 @@
+// Front end cost per sample, and frames decoded with and without it from noisy audio with de-emphasis twist
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -I.. frontend.cpp -o frontend && ./frontend [noise] [de-emphasis corner Hz]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../afsk.hpp"
+#include "../frontend.hpp"
+
+int main(int argc, char *argv[])
+{
+    const double noise = argc > 1 ? std::atof(argv[1]) : 20;
+    const double corner = argc > 2 ? std::atof(argv[2]) : 600;
+
+    std::set<std::vector<uint8_t>> sent;
+    std::vector<float> audio;
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        auto packet = APRSPacket("BENCH", i % 16, ">front end benchmark " + std::to_string(i)).Encode();
+        auto samples = AFSK::Encoder::Encode<float>(packet, 4, 4);
+
+        sent.insert(packet);
+        audio.insert(audio.end(), samples.begin(), samples.end());
+        audio.insert(audio.end(), 500, 0.0f);
+    }
+
+    // first-order lowpass, the twist of a receiver's de-emphasis
+    const double a = corner > 0 ? 1 - std::exp(-2 * M_PI * corner / AFSK::sample_rate) : 1;
+    double y = 0, peak = 0;
+
+    for (auto &sample : audio)
+    {
+        y += a * (sample - y);
+        sample = y;
+        peak = std::max<double>(peak, std::abs(y));
+    }
+
+    std::mt19937 rng(1);
+    std::normal_distribution<double> gauss(0, noise);
+    std::vector<uint8_t> samples(audio.size());
+
+    for (size_t i = 0; i < audio.size(); ++i)
+    {
+        samples[i] = std::clamp<long>(std::lround(128 + 64 * audio[i] / peak + gauss(rng)), 0, 255);
+    }
+
+    for (bool enabled : {false, true})
+    {
+        size_t good = 0;
+        Filtered<AFSK::Decoder::PLLStream> decoder(enabled, [&](const std::vector<uint8_t> &frame) { good += sent.count(frame); });
+
+        auto start = std::chrono::steady_clock::now();
+        decoder.feed(samples);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << (enabled ? "with front end: " : "without: ") << good << "/" << sent.size() << " frames, "
+                  << samples.size() / elapsed.count() << " samples/s";
+
+        if (enabled)
+        {
+            std::cout << ", twist " << decoder.front().twist() << " dB";
+        }
+
+        std::cout << std::endl;
+    }
+
+    // the front end alone, over a longer run
+    std::vector<uint8_t> out(samples.size());
+    FrontEnd frontend;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i)
+    {
+        frontend.process(samples.data(), samples.size(), out.data());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double rate = 20 * samples.size() / elapsed.count();
+    std::cout << "front end alone: " << rate << " samples/s (" << rate / AFSK::sample_rate << " channels in real time)"
+              << std::endl;
+}
@@ -0,0 +1,128 @@
+// APRS info-field parser benchmark: replays a mixed corpus of frames through AX25FrameView + APRSInfo::Parse
+// APRSPacket::Decode (which copies everything into strings) is timed as a reference, and so are frames failing the FCS
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -I.. info.cpp -o info && ./info [frames]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../aprs_info.hpp"
+#include "../ax25.hpp"
+
+// an encoded frame with the destination replaced, Mic-E keeps its latitude there
+static std::vector<uint8_t> frame(const std::string &destination, const std::string &info)
+{
+    auto packet = APRSPacket("BENCH", 1, info, {"WIDE1-1", "WIDE2-1"}).Encode();
+
+    AX25Address address;
+    AX25Address::Parse(destination, address);
+    address.h = true;
+    address.Write(packet.data());
+    CRC16::patch(packet.data(), packet.size());
+
+    return packet;
+}
+
+template <typename F>
+static void run(const std::string &name, size_t frames, F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    volatile long sink = f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+
+    std::cout << name << ": " << frames / elapsed.count() << " frames/s" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+    // roughly the mix seen on APRS-IS: mostly positions and Mic-E, some messages, status, objects and telemetry
+    const std::vector<std::vector<uint8_t>> corpus = {
+        frame("APRS", "!4903.50N/07201.75W-Test 001234"),
+        frame("APRS", "=4903.50N/07201.75W>088/036/A=001234 mobile"),
+        frame("APRS", "@092345z4903.50N/07201.75W>"),
+        frame("APRS", "!/5L!!<*e7>7P["),
+        frame("APRS", "=/5L!!<*e7OS]S"),
+        frame("T2SP0W", "`c51!f?>/]\"4.}="),
+        frame("S32U6T", "`(_fn\"Oj/]Mic-E comment"),
+        frame("APRS", ":WU2Z     :Testing{003"),
+        frame("APRS", ":WU2Z     :ack003"),
+        frame("APRS", ">092345zNet Control Center"),
+        frame("APRS", ";LEADER   *092345z4903.50N/07201.75W>088/036"),
+        frame("APRS", "T#005,199,000,255,073,123,01101001"),
+    };
+
+    run("AX25FrameView + APRSInfo::Parse", count, [&] {
+        long sum = 0;
+        APRSInfo info;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto &f = corpus[i % corpus.size()];
+            AX25FrameView view(f.data(), f.size());
+
+            if (view.IsValid() && view.HasValidFCS() && APRSInfo::Parse(view, info))
+            {
+                sum += info.type;
+            }
+        }
+
+        return sum;
+    });
+
+    run("APRSPacket::Decode", count, [&] {
+        long sum = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            sum += APRSPacket::Decode(corpus[i % corpus.size()]).custom_data.size();
+        }
+
+        return sum;
+    });
+
+    // the same frames with a broken FCS, as routinely comes off the air
+    auto corrupted = corpus;
+    for (auto &f : corrupted)
+    {
+        f.back() ^= 0x5A;
+    }
+
+    const size_t bad = count / 10;
+
+    run("bad frames, APRSPacket::Decode (throws)", bad, [&] {
+        long sum = 0;
+
+        for (size_t i = 0; i < bad; ++i)
+        {
+            try
+            {
+                sum += APRSPacket::Decode(corrupted[i % corrupted.size()]).custom_data.size();
+            }
+            catch (const std::exception &)
+            {
+                --sum;
+            }
+        }
+
+        return sum;
+    });
+
+    run("bad frames, APRSPacket::TryDecode", bad, [&] {
+        long sum = 0;
+
+        for (size_t i = 0; i < bad; ++i)
+        {
+            auto packet = APRSPacket::TryDecode(corrupted[i % corrupted.size()]);
+            sum += packet ? packet->custom_data.size() : -1;
+        }
+
+        return sum;
+    });
+}
@@ -0,0 +1,135 @@
+// KISS framing cost, and decoded frames per second reaching a host through the TNC over TCP loopback
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -pthread -I.. kiss.cpp -o kiss && ./kiss [frames]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../aprs.hpp"
+#include "../kiss.hpp"
+#include "../tnc.hpp"
+
+template <typename F>
+static void run(const std::string &name, size_t frames, F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    volatile long sink = f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+
+    std::cout << name << ": " << frames / elapsed.count() << " frames/s" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    // FEND and FESC in the info field as well, so escaping is part of it
+    std::vector<std::vector<uint8_t>> corpus;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        std::string info = "!4903.50N/07201.75W-KISS benchmark " + std::to_string(i);
+        info[10 + i] = i % 2 ? '\xC0' : '\xDB';
+        corpus.push_back(APRSPacket("BENCH", i, info, {"WIDE1-1", "WIDE2-1"}).Encode());
+    }
+
+    std::vector<uint8_t> stream;
+
+    run("KISS::Encode", count, [&] {
+        long sum = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            stream.clear();
+            KISS::Encode(corpus[i % corpus.size()], stream);
+            sum += stream.size();
+        }
+
+        return sum;
+    });
+
+    stream.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        KISS::Encode(corpus[i % corpus.size()], stream);
+    }
+
+    run("KISS::Decoder", count, [&] {
+        long sum = 0;
+        KISS::Decoder decoder;
+
+        // in socket-sized reads
+        for (size_t i = 0; i < stream.size(); i += 4096)
+        {
+            decoder.feed(stream.data() + i, std::min<size_t>(4096, stream.size() - i),
+                [&](uint8_t, KISS::Command, const uint8_t *, size_t size) { sum += size; });
+        }
+
+        return sum;
+    });
+
+    // a decoder thread calling send() as fast as it can, the loop batching whatever piled up meanwhile
+    TNC tnc([](const std::vector<TNC::frame> &, const AFSK::Encoder::tx_options &) {});
+    const uint16_t port = tnc.listen(0);
+    std::thread loop([&] { tnc.run(); });
+
+    const int host = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = { };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(host, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "can't connect to the TNC" << std::endl;
+        return 1;
+    }
+
+    // the TNC only sends to hosts it has accepted
+    while (tnc.host_count() == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    const size_t frames = count / 10;
+
+    run("TNC over TCP loopback", frames, [&] {
+        std::thread producer([&] {
+            for (size_t i = 0; i < frames; ++i)
+            {
+                tnc.send(0, corpus[i % corpus.size()]);
+            }
+        });
+
+        size_t received = 0;
+        KISS::Decoder decoder;
+        std::vector<uint8_t> buffer(1 << 16);
+
+        while (received < frames)
+        {
+            const ssize_t n = read(host, buffer.data(), buffer.size());
+            if (n <= 0)
+            {
+                break;
+            }
+
+            decoder.feed(buffer.data(), n, [&](uint8_t, KISS::Command, const uint8_t *, size_t) { ++received; });
+        }
+
+        producer.join();
+        return long(received);
+    });
+
+    close(host);
+    tnc.stop();
+    loop.join();
+}
@@ -0,0 +1,129 @@
+// SPSC sample ring: throughput of batch copies vs zero-copy regions, and producer-to-consumer latency
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -pthread -I.. ring.cpp -o ring && ./ring [megasamples]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../spsc.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+// one producer and one consumer thread moving total samples in blocks
+template <typename T, typename Producer, typename Consumer>
+static void throughput(const std::string &name, size_t total, Producer &&produce, Consumer &&consume)
+{
+    SPSCRing<T> ring(1 << 16);
+    auto start = clock_type::now();
+
+    std::thread producer([&] {
+        for (size_t done = 0; done < total;)
+        {
+            const size_t n = produce(ring, total - done);
+            done += n;
+
+            if (!n)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    long sum = 0;
+    for (size_t done = 0; done < total;)
+    {
+        const size_t n = consume(ring, sum);
+        done += n;
+
+        if (!n)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    std::cout << name << ": " << total / elapsed.count() << " samples/s (checksum " << sum << ")" << std::endl;
+}
+
+template <typename T>
+static void run(const std::string &type, size_t total)
+{
+    const size_t block = 1024;
+    std::vector<T> in(block, 1), out(block);
+
+    throughput<T>(type + " push/pop", total,
+        [&](SPSCRing<T> &ring, size_t left) {
+            return ring.push(in.data(), std::min(block, left));
+        },
+        [&](SPSCRing<T> &ring, long &sum) {
+            const size_t n = ring.pop(out.data(), block);
+            sum += n ? out[0] : 0;
+            return n;
+        });
+
+    throughput<T>(type + " claim/peek", total,
+        [&](SPSCRing<T> &ring, size_t left) {
+            size_t n = std::min(block, left);
+            T *p = ring.claim(n);
+            std::fill(p, p + n, T(1));
+            ring.commit(n);
+            return n;
+        },
+        [&](SPSCRing<T> &ring, long &sum) {
+            size_t n = block;
+            const T *p = ring.peek(n);
+            sum += n ? p[0] : 0;
+            ring.release(n);
+            return n;
+        });
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t total = (argc > 1 ? std::atoi(argv[1]) : 256) << 20;
+
+    run<uint8_t>("uint8_t", total);
+    run<int16_t>("int16_t", total);
+
+    // handoff latency: one block at a time, the producer waits until it has been consumed
+    SPSCRing<int64_t> ring(1 << 10);
+    const size_t rounds = 10000;
+    std::vector<double> latency;
+    latency.reserve(rounds);
+
+    std::thread consumer([&] {
+        for (size_t i = 0; i < rounds;)
+        {
+            int64_t stamp;
+            if (ring.pop(&stamp, 1))
+            {
+                latency.push_back((clock_type::now().time_since_epoch().count() - stamp) / 1000.0);
+                ++i;
+            }
+        }
+    });
+
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        const int64_t stamp = clock_type::now().time_since_epoch().count();
+        ring.push(&stamp, 1);
+
+        while (ring.size())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+    std::sort(latency.begin(), latency.end());
+
+    std::cout << "handoff latency: p50 " << latency[rounds / 2] << " us, p99 " << latency[rounds * 99 / 100]
+              << " us, max " << latency.back() << " us" << std::endl;
+}
@@ -0,0 +1,213 @@
+// Decoder sensitivity and throughput over a matrix of synthetic channels, as JSON for regression tracking
+// Every decoder sees the same seeded corpus; frames, bit errors of the frames it did deliver, and speed are reported
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -pthread -I.. suite.cpp -o suite && ./suite [frames per channel] [seed] > results.json
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../afsk.hpp"
+#include "../engine.hpp"
+#include "../frontend.hpp"
+#include "../phase_search.hpp"
+#include "corpus.hpp"
+
+using frames = std::vector<std::vector<uint8_t>>;
+
+struct Decoder
+{
+    std::string name;
+
+    // everything the decoder handed over, valid FCS or not
+    std::function<frames(const Corpus &)> run;
+};
+
+struct Result
+{
+    size_t decoded = 0;
+    size_t false_frames = 0;
+
+    // delivered frames that line up with a sent one (same size, under 1/8 of the bits wrong)
+    size_t aligned = 0;
+    size_t bits = 0;
+    size_t bit_errors = 0;
+
+    double samples_per_second = 0;
+};
+
+static size_t hamming(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    size_t d = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        d += __builtin_popcount(a[i] ^ b[i]);
+    }
+    return d;
+}
+
+static Result score(const Corpus &corpus, const frames &output)
+{
+    Result r;
+    std::set<std::vector<uint8_t>> sent(corpus.frames.begin(), corpus.frames.end()), seen;
+    std::map<size_t, std::vector<const std::vector<uint8_t> *>> by_size;
+
+    for (const auto &f : corpus.frames)
+    {
+        by_size[f.size()].push_back(&f);
+    }
+
+    for (const auto &f : output)
+    {
+        const bool valid = CRC16::check(f.data(), f.size());
+
+        if (valid && sent.count(f))
+        {
+            r.decoded += seen.insert(f).second;
+        }
+        else if (valid)
+        {
+            ++r.false_frames;
+        }
+
+        // closest sent frame of the same size
+        size_t best = SIZE_MAX;
+        for (auto *candidate : by_size[f.size()])
+        {
+            best = std::min(best, hamming(f, *candidate));
+        }
+
+        if (best < f.size())
+        {
+            ++r.aligned;
+            r.bits += f.size() * 8;
+            r.bit_errors += best;
+        }
+    }
+
+    return r;
+}
+
+// single-frame decoders get each frame's own stretch of audio
+template <typename Demod>
+static Decoder per_frame(const std::string &name, Demod demod)
+{
+    return {name, [demod](const Corpus &corpus) {
+                frames out;
+                for (size_t i = 0; i < corpus.frames.size(); ++i)
+                {
+                    std::vector<uint8_t> audio(corpus.samples.begin() + corpus.begin[i], corpus.samples.begin() + corpus.end[i]);
+                    auto f = demod(audio, 0);
+
+                    if (!f.empty())
+                    {
+                        out.push_back(std::move(f));
+                    }
+                }
+                return out;
+            }};
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::atoi(argv[1]) : 200;
+    const uint32_t seed = argc > 2 ? std::atoi(argv[2]) : 1;
+
+    const std::vector<std::pair<std::string, ChannelModel>> channels = {
+        {"clean", {0, 0, 0}},
+        {"noise 12", {12, 0, 0}},
+        {"noise 20", {20, 0, 0}},
+        {"noise 28", {28, 0, 0}},
+        {"de-emphasis 6 dB", {12, 6, 0}},
+        {"pre-emphasis 6 dB", {12, -6, 0}},
+        {"fast clock 0.5%", {12, 0, 5000}},
+        {"slow clock 0.5%", {12, 0, -5000}},
+        {"combined", {20, 6, 2000}},
+    };
+
+    const std::vector<Decoder> decoders = {
+        per_frame("demod_naive", AFSK::Decoder::demod_naive),
+        per_frame("demod", AFSK::Decoder::demod),
+        {"stream",
+            [](const Corpus &corpus) {
+                frames out;
+                AFSK::Decoder::Stream decoder([&](const std::vector<uint8_t> &f) { out.push_back(f); });
+                decoder.feed(corpus.samples);
+                return out;
+            }},
+        {"pll",
+            [](const Corpus &corpus) {
+                frames out;
+                AFSK::Decoder::PLLStream decoder([&](const std::vector<uint8_t> &f) { out.push_back(f); });
+                decoder.feed(corpus.samples);
+                return out;
+            }},
+        {"pll fix_bits 2",
+            [](const Corpus &corpus) {
+                frames out;
+                AFSK::Decoder::PLLStream decoder([&](const std::vector<uint8_t> &f) { out.push_back(f); }, 2);
+                decoder.feed(corpus.samples);
+                return out;
+            }},
+        {"front end + pll",
+            [](const Corpus &corpus) {
+                frames out;
+                Filtered<AFSK::Decoder::PLLStream> decoder(true, [&](const std::vector<uint8_t> &f) { out.push_back(f); });
+                decoder.feed(corpus.samples);
+                return out;
+            }},
+        {"phase search",
+            [](const Corpus &corpus) {
+                frames out;
+                for (auto &f : PhaseSearchDecoder::decode(corpus.samples, 1))
+                {
+                    out.push_back(std::move(f.data));
+                }
+                return out;
+            }},
+        {"engine (cli)",
+            [](const Corpus &corpus) {
+                frames out;
+                DecoderEngine engine(1, AFSK::sample_rate, 1, 2, true);
+                engine.feed(0, corpus.samples);
+                engine.finish();
+                engine.poll([&](const DecoderEngine::frame &f) { out.push_back(f.data); });
+                return out;
+            }},
+    };
+
+    std::cout << "{\n  \"frames\": " << count << ",\n  \"seed\": " << seed << ",\n  \"results\": [";
+
+    const char *separator = "\n";
+
+    for (const auto &[channel, model] : channels)
+    {
+        const Corpus corpus(model, count, seed);
+
+        for (const auto &decoder : decoders)
+        {
+            auto start = std::chrono::steady_clock::now();
+            const auto output = decoder.run(corpus);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            Result r = score(corpus, output);
+            r.samples_per_second = corpus.samples.size() / elapsed.count();
+
+            std::cout << separator << "    {\"channel\": \"" << channel << "\", \"noise\": " << model.noise
+                      << ", \"twist\": " << model.twist << ", \"skew_ppm\": " << model.skew << ", \"decoder\": \""
+                      << decoder.name << "\", \"decoded\": " << r.decoded << ", \"false_frames\": " << r.false_frames
+                      << ", \"aligned_frames\": " << r.aligned
+                      << ", \"ber\": " << (r.bits ? double(r.bit_errors) / r.bits : 0)
+                      << ", \"samples_per_second\": " << r.samples_per_second << "}";
+
+            separator = ",\n";
+        }
+    }
+
+    std::cout << "\n  ]\n}" << std::endl;
+}
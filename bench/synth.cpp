@@ -0,0 +1,60 @@
+// AFSK synthesizer throughput per output format and rate, and how many channels that is in real time
+// g++ -O2 -std=c++17 -DAPRS_METRICS=0 -I.. synth.cpp -o synth && ./synth [frames]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../afsk.hpp"
+
+template <typename T>
+static void run(const std::string &name, size_t rate, const std::vector<APRSPacket> &packets)
+{
+    size_t bytes = 0;
+    for (auto &packet : packets)
+    {
+        bytes += packet.Encode().size();
+    }
+
+    const AFSK::Encoder::tx_options options;
+    std::vector<T> out(AFSK::Encoder::max_samples(
+        packets.size() * (options.gap + 1) + options.txdelay + options.txtail, bytes, rate));
+
+    auto batch = packets;
+    size_t samples;
+    auto start = std::chrono::steady_clock::now();
+    const size_t encoded = AFSK::Encoder::EncodeBatch(batch, out.data(), out.size(), samples, options, rate);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (encoded != packets.size())
+    {
+        std::cerr << name << " at " << rate << " Hz: only " << encoded << " of " << packets.size() << " packets fit" << std::endl;
+        std::exit(1);
+    }
+
+    const double speed = samples / elapsed.count();
+    std::cout << name << " at " << rate << " Hz: " << speed << " samples/s, " << speed / rate
+              << " channels in real time" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    std::vector<APRSPacket> packets;
+    for (size_t i = 0; i < count; ++i)
+    {
+        packets.emplace_back("BENCH", i % 16, "!4903.50N/07201.75W-synth benchmark " + std::to_string(i),
+            std::vector<std::string>{"WIDE1-1", "WIDE2-1"});
+    }
+
+    run<uint8_t>("uint8_t", AFSK::sample_rate, packets);
+    run<uint8_t>("uint8_t", 22050, packets);
+    run<int16_t>("int16_t", 44100, packets);
+    run<int16_t>("int16_t", 48000, packets);
+    run<float>("float", 48000, packets);
+}
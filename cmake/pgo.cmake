@@ -0,0 +1,79 @@
+# Profile-guided build: instrumented build -> training run on the benchmark corpus -> optimized rebuild
+# cmake -DSOURCE_DIR=<repo> -DBINARY_DIR=<build dir> [-DCXX_COMPILER=...] [-DLTO=ON] [-DNATIVE=ON] -P pgo.cmake
+# the CLI ends up in <build dir>/aprs, the benchmarks in <build dir>/bench
+
+if(NOT SOURCE_DIR OR NOT BINARY_DIR)
+    message(FATAL_ERROR "pgo.cmake needs SOURCE_DIR and BINARY_DIR")
+endif()
+
+set(profile_dir ${BINARY_DIR}/profile)
+set(training_dir ${BINARY_DIR}/training)
+
+set(options -DCMAKE_BUILD_TYPE=Release -DAPRS_BENCHMARKS=ON -DAPRS_PGO_DIR=${profile_dir})
+if(CXX_COMPILER)
+    list(APPEND options -DCMAKE_CXX_COMPILER=${CXX_COMPILER})
+endif()
+if(LTO)
+    list(APPEND options -DAPRS_LTO=${LTO})
+endif()
+if(NATIVE)
+    list(APPEND options -DAPRS_NATIVE=${NATIVE})
+endif()
+
+function(run)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY ${training_dir} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "pgo: '${ARGN}' failed: ${result}")
+    endif()
+endfunction()
+
+function(build stage)
+    message(STATUS "pgo: ${stage} build")
+    run(${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${BINARY_DIR} ${options} -DAPRS_PGO=${stage})
+    run(${CMAKE_COMMAND} --build ${BINARY_DIR} --parallel)
+endfunction()
+
+# stale profiles from an earlier run would be merged into the new one
+file(REMOVE_RECURSE ${profile_dir} ${training_dir})
+file(MAKE_DIRECTORY ${profile_dir} ${training_dir})
+file(GLOB_RECURSE stale ${BINARY_DIR}/*.gcda)
+if(stale)
+    file(REMOVE ${stale})
+endif()
+
+build(GENERATE)
+
+# every executable is profiled on its own, so each one has to run: the CLI on clean and twisted channels,
+# through both the phase search (file) and the streaming engine (stdin), then every benchmark
+message(STATUS "pgo: training")
+run(${BINARY_DIR}/bench/corpus clean.wav 300 1 4)
+run(${BINARY_DIR}/bench/corpus noisy.wav 300 2 20 6)
+
+foreach(wav clean.wav noisy.wav)
+    run(${BINARY_DIR}/aprs -d ${wav} OUTPUT_QUIET)
+    run(sh -c "${BINARY_DIR}/aprs -d - < ${wav} > /dev/null")
+endforeach()
+
+run(${BINARY_DIR}/aprs N0CALL 3 profile training ${training_dir}/selftest.wav OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/suite 50 1 OUTPUT_QUIET)
+
+# the benchmarks on runs short enough for an instrumented build
+run(${BINARY_DIR}/bench/correlator 10 OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/engine 4 10 OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/frontend OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/info 200000 OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/kiss 100000 OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/ring 16 OUTPUT_QUIET)
+run(${BINARY_DIR}/bench/synth 1000 OUTPUT_QUIET)
+
+file(GLOB raw ${profile_dir}/*.profraw)
+if(raw)
+    find_program(llvm_profdata NAMES llvm-profdata)
+    if(NOT llvm_profdata)
+        message(FATAL_ERROR "pgo: llvm-profdata not found")
+    endif()
+    run(${llvm_profdata} merge -output=${profile_dir}/merged.profdata ${raw})
+endif()
+
+build(USE)
+message(STATUS "pgo: done, ${BINARY_DIR}/aprs")
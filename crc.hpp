@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using crc16_table_set = std::array<std::array<uint16_t, 256>, 8>;
+
+// CRC-16-CCITT lookup tables: t[0] is the classic byte-wise table, t[k][i] is byte i followed by k zero bytes
+constexpr crc16_table_set crc16_tables()
+{
+    crc16_table_set t = { };
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        uint16_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = crc & 1 ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+        t[0][i] = crc;
+    }
+
+    // t[k][i]: i followed by k zero bytes
+    for (size_t k = 1; k < 8; ++k)
+    {
+        for (size_t i = 0; i < 256; ++i)
+        {
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        }
+    }
+
+    return t;
+}
+
+// CRC-16-CCITT as used by the AX.25 FCS (reflected polynomial 0x8408, init and final xor 0xFFFF)
+// Slice-by-8: 8 bytes per step using tables generated at compile time
+struct CRC16
+{
+    static constexpr uint16_t init = 0xFFFF;
+
+    // the register after running a frame with a valid FCS through update()
+    static constexpr uint16_t good_residue = 0xF0B8;
+
+    using table_set = crc16_table_set;
+
+    static constexpr table_set tables = crc16_tables();
+
+    // single byte step, for incremental use
+    static uint16_t update(uint16_t crc, uint8_t data)
+    {
+        return (crc >> 8) ^ tables[0][(crc ^ data) & 0xFF];
+    }
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, size_t size)
+    {
+        const auto &t = tables;
+
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            const uint8_t lo = data[0] ^ (crc & 0xFF);
+            const uint8_t hi = data[1] ^ (crc >> 8);
+
+            crc = t[7][lo] ^ t[6][hi] ^ t[5][data[2]] ^ t[4][data[3]] ^
+                  t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        }
+
+        for (; size; --size)
+        {
+            crc = update(crc, *data++);
+        }
+
+        return crc;
+    }
+
+    // FCS of a frame, to be sent low byte first
+    static uint16_t compute(const uint8_t *data, size_t size)
+    {
+        return ~update(init, data, size);
+    }
+
+    // the CRC is linear: flipping data bit d (LSB first, of count bits) changes the register by out[d],
+    // so a candidate bit error can be checked against the residue without rerunning the CRC
+    static void syndromes(size_t count, uint16_t *out)
+    {
+        uint16_t s = 0x8408;
+
+        for (size_t d = count; d-- > 0;)
+        {
+            out[d] = s;
+            s = s & 1 ? (s >> 1) ^ 0x8408 : s >> 1;
+        }
+    }
+
+    // rewrites the trailing 2-byte FCS of a frame after its contents were changed in place
+    static void patch(uint8_t *frame, size_t size)
+    {
+        const uint16_t crc = compute(frame, size - 2);
+        frame[size - 2] = crc & 0xFF;
+        frame[size - 1] = crc >> 8;
+    }
+
+    // checks a frame that ends with its 2-byte FCS
+    static bool check(const uint8_t *frame, size_t size)
+    {
+        return size > 2 && update(init, frame, size) == good_residue;
+    }
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "ax25.hpp"
+
+// Time-windowed duplicate frame filter, as used by APRS digipeaters and igates
+// Frames are keyed on source, destination and info, so copies arriving over different paths count as duplicates
+// Open addressing over a fixed table of 64-bit hashes: O(1) per frame, no allocations, entries simply expire
+// Time is in whatever unit the caller uses (samples, milliseconds), only differences matter
+template <size_t Slots = 1024>
+class DupeCache
+{
+    static_assert(Slots && (Slots & (Slots - 1)) == 0, "the slot count must be a power of two");
+
+  public:
+    explicit DupeCache(uint64_t window)
+        : window(window)
+    {
+    }
+
+    // returns true if the frame was already seen within the window, otherwise remembers it
+    bool Check(const AX25FrameView &frame, uint64_t now)
+    {
+        return Check(Hash(frame), now);
+    }
+
+    bool Check(uint64_t hash, uint64_t now)
+    {
+        // 0 marks an empty slot
+        hash |= hash == 0;
+
+        const size_t home = hash & (Slots - 1);
+        Entry *victim = nullptr;
+        bool victim_free = false;
+
+        for (size_t i = 0; i < probes; ++i)
+        {
+            Entry &e = slots[(home + i) & (Slots - 1)];
+            // a timestamp older than the entry (frames merged out of order) is still inside its window
+            const bool live = e.hash && (now < e.time || now - e.time <= window);
+
+            if (live && e.hash == hash)
+            {
+                return true;
+            }
+
+            // prefer a free or expired slot, otherwise evict the oldest one in reach
+            if (!live)
+            {
+                if (!victim_free)
+                {
+                    victim = &e;
+                    victim_free = true;
+                }
+            }
+            else if (!victim_free && (!victim || e.time < victim->time))
+            {
+                victim = &e;
+            }
+        }
+
+        victim->hash = hash;
+        victim->time = now;
+        return false;
+    }
+
+    void Clear()
+    {
+        slots.fill(Entry());
+    }
+
+    // FNV-1a over destination, source and info, the digipeater path and H/C bits are ignored
+    static uint64_t Hash(const AX25FrameView &frame)
+    {
+        uint64_t hash = 0xCBF29CE484222325;
+
+        const auto destination = frame.Destination();
+        const auto source = frame.Source();
+
+        hash = fnv(hash, destination.callsign());
+        hash = fnv(hash, std::string_view("-", 1));
+        hash = fnv(hash, std::string_view(reinterpret_cast<const char *>(&destination.ssid), 1));
+        hash = fnv(hash, source.callsign());
+        hash = fnv(hash, std::string_view(">", 1));
+        hash = fnv(hash, std::string_view(reinterpret_cast<const char *>(&source.ssid), 1));
+
+        // some digipeaters append or strip trailing whitespace
+        std::string_view info = frame.Info();
+        while (!info.empty() && (info.back() == ' ' || info.back() == '\r' || info.back() == '\n'))
+        {
+            info.remove_suffix(1);
+        }
+
+        return fnv(hash, info);
+    }
+
+  private:
+    // how far a hash may land from its home slot
+    static const size_t probes = 8;
+
+    struct Entry
+    {
+        uint64_t hash = 0;
+        uint64_t time = 0;
+    };
+
+    static uint64_t fnv(uint64_t hash, std::string_view data)
+    {
+        for (char c : data)
+        {
+            hash = (hash ^ uint8_t(c)) * 0x100000001B3;
+        }
+        return hash;
+    }
+
+    std::array<Entry, Slots> slots = { };
+    uint64_t window;
+};
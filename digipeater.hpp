@@ -0,0 +1,137 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ax25.hpp"
+#include "crc.hpp"
+#include "stack_guards.hpp"
+
+// APRS digipeater using the WIDEn-N paradigm
+// Rewrites the path of a received frame in place and patches the FCS, the rest of the frame is never touched
+// Tracing (inserting our callsign ahead of a partially used WIDEn-N) would change the frame length, so it isn't done
+class Digipeater
+{
+  public:
+    // aliases are generic WIDEn-N style prefixes, "WIDE" matches WIDE1-1 through WIDE7-7
+    Digipeater(
+        const std::string &callsign,
+        uint8_t ssid = 0,
+        const std::vector<std::string> &aliases = {"WIDE"},
+        uint8_t max_hops = 2)
+        : aliases(aliases),
+          max_hops(max_hops)
+    {
+        BEGIN();
+
+        if (!AX25Address::Parse(callsign, own) || ssid > 15)
+        {
+            throw EXCEPTION("Invalid digipeater callsign " + callsign);
+        }
+
+        own.ssid = ssid;
+
+        END();
+    }
+
+    // returns true if the frame should be retransmitted, in which case it has been rewritten
+    // frames that are malformed, fail the FCS or aren't for us are left as they are
+    bool Rewrite(uint8_t *frame, size_t size) const
+    {
+        const AX25FrameView view(frame, size);
+
+        if (!view.IsValid() || !view.HasValidFCS())
+        {
+            return false;
+        }
+
+        // never repeat our own transmissions back
+        if (view.Source().Matches(own.callsign(), own.ssid))
+        {
+            return false;
+        }
+
+        // the first hop without the H bit is the one to act on
+        size_t hop = 0;
+        while (hop < view.Digipeaters() && view.Digipeater(hop).h)
+        {
+            ++hop;
+        }
+
+        if (hop == view.Digipeaters())
+        {
+            return false;
+        }
+
+        uint8_t *raw = frame + AX25FrameView::DigipeaterOffset(hop);
+        AX25Address address(raw);
+
+        if (address.Matches(own.callsign(), own.ssid))
+        {
+            // explicitly routed through us
+            address.h = true;
+        }
+        else if (size_t n = generic_hops(address))
+        {
+            if (n > max_hops || address.ssid > n)
+            {
+                return false;
+            }
+
+            if (--address.ssid == 0)
+            {
+                // used up, shows we were the last hop
+                const bool last = address.last;
+                address = own;
+                address.h = true;
+                address.last = last;
+            }
+        }
+        else
+        {
+            return false;
+        }
+
+        address.Write(raw);
+        CRC16::patch(frame, size);
+
+        return true;
+    }
+
+    bool Rewrite(std::vector<uint8_t> &frame) const
+    {
+        return Rewrite(frame.data(), frame.size());
+    }
+
+  private:
+    // n of an unused WIDEn-N hop matching one of our aliases, 0 if it doesn't match
+    size_t generic_hops(const AX25Address &address) const
+    {
+        const std::string_view callsign = address.callsign();
+
+        if (callsign.empty() || address.ssid == 0)
+        {
+            return 0;
+        }
+
+        const char n = callsign.back();
+        if (n < '1' || n > '7')
+        {
+            return 0;
+        }
+
+        for (const auto &alias : aliases)
+        {
+            if (callsign.substr(0, callsign.size() - 1) == alias)
+            {
+                return n - '0';
+            }
+        }
+
+        return 0;
+    }
+
+    AX25Address own;
+    std::vector<std::string> aliases;
+    uint8_t max_hops;
+};
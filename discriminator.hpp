@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "profile.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISCRIMINATOR_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DISCRIMINATOR_NEON 1
+#endif
+
+// Mark/space discriminator for 8-sample (1 baud @ 9600 Hz) windows
+// Computes the 2200 Hz minus 1200 Hz energy, > 0 means 2200 Hz
+// All kernels produce bit-identical results, the best one is picked at runtime
+struct Discriminator
+{
+    using profile = Bell202;
+
+    static constexpr size_t taps = profile::taps;
+    static_assert(taps == 8, "the SIMD kernels hold exactly one window per 128-bit register");
+
+    static constexpr auto &coeffloi = profile::coeffloi;
+    static constexpr auto &coeffloq = profile::coeffloq;
+    static constexpr auto &coeffhii = profile::coeffhii;
+    static constexpr auto &coeffhiq = profile::coeffhiq;
+
+    // computes out[k] for the window starting at samples + k * stride, k < count
+    using kernel = void (*)(const uint8_t *samples, size_t stride, size_t count, int *out);
+
+    // reference implementation for a single window
+    static int window(const uint8_t *data)
+    {
+        return profile::window(data);
+    }
+
+    static void scalar(const uint8_t *samples, size_t stride, size_t count, int *out)
+    {
+        for (size_t k = 0; k < count; ++k)
+        {
+            out[k] = window(samples + k * stride);
+        }
+    }
+
+#if DISCRIMINATOR_X86
+    // 4 windows per iteration
+    __attribute__((target("sse2"))) static void sse2(const uint8_t *samples, size_t stride, size_t count, int *out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+
+        const __m128i loi = load_coefficients_sse2(coeffloi.data());
+        const __m128i loq = load_coefficients_sse2(coeffloq.data());
+        const __m128i hii = load_coefficients_sse2(coeffhii.data());
+        const __m128i hiq = load_coefficients_sse2(coeffhiq.data());
+
+        size_t k = 0;
+
+        for (; k + 4 <= count; k += 4)
+        {
+            __m128i w[4];
+
+            for (int j = 0; j < 4; ++j)
+            {
+                __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + (k + j) * stride));
+                w[j] = _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias);
+            }
+
+            // one lane per window
+            __m128i sloi = dot4_sse2(w, loi);
+            __m128i sloq = dot4_sse2(w, loq);
+            __m128i shii = dot4_sse2(w, hii);
+            __m128i shiq = dot4_sse2(w, hiq);
+
+            // magnitudes fit 16 bits after the shift, so pairs can be squared and summed with a single madd
+            __m128i lo = _mm_packs_epi32(_mm_srai_epi32(sloi, 8), _mm_srai_epi32(sloq, 8));
+            __m128i hi = _mm_packs_epi32(_mm_srai_epi32(shii, 8), _mm_srai_epi32(shiq, 8));
+            lo = _mm_unpacklo_epi16(lo, _mm_unpackhi_epi64(lo, lo));
+            hi = _mm_unpacklo_epi16(hi, _mm_unpackhi_epi64(hi, hi));
+
+            __m128i result = _mm_sub_epi32(_mm_madd_epi16(hi, hi), _mm_madd_epi16(lo, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), result);
+        }
+
+        scalar(samples + k * stride, stride, count - k, out + k);
+    }
+
+    // 8 windows per iteration, 4 per 128-bit lane
+    __attribute__((target("avx2"))) static void avx2(const uint8_t *samples, size_t stride, size_t count, int *out)
+    {
+        const __m256i bias = _mm256_set1_epi16(128);
+
+        const __m256i loi = _mm256_broadcastsi128_si256(load_coefficients_sse2(coeffloi.data()));
+        const __m256i loq = _mm256_broadcastsi128_si256(load_coefficients_sse2(coeffloq.data()));
+        const __m256i hii = _mm256_broadcastsi128_si256(load_coefficients_sse2(coeffhii.data()));
+        const __m256i hiq = _mm256_broadcastsi128_si256(load_coefficients_sse2(coeffhiq.data()));
+
+        size_t k = 0;
+
+        for (; k + 8 <= count; k += 8)
+        {
+            __m256i w[4];
+
+            // window k + j goes to the low lane, k + j + 4 to the high one
+            for (int j = 0; j < 4; ++j)
+            {
+                __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + (k + j) * stride)));
+                __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + (k + j + 4) * stride)));
+                w[j] = _mm256_sub_epi16(_mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1), bias);
+            }
+
+            __m256i sloi = dot4_avx2(w, loi);
+            __m256i sloq = dot4_avx2(w, loq);
+            __m256i shii = dot4_avx2(w, hii);
+            __m256i shiq = dot4_avx2(w, hiq);
+
+            __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(sloi, 8), _mm256_srai_epi32(sloq, 8));
+            __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(shii, 8), _mm256_srai_epi32(shiq, 8));
+            lo = _mm256_unpacklo_epi16(lo, _mm256_unpackhi_epi64(lo, lo));
+            hi = _mm256_unpacklo_epi16(hi, _mm256_unpackhi_epi64(hi, hi));
+
+            __m256i result = _mm256_sub_epi32(_mm256_madd_epi16(hi, hi), _mm256_madd_epi16(lo, lo));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), result);
+        }
+
+        sse2(samples + k * stride, stride, count - k, out + k);
+    }
+#endif
+
+#if DISCRIMINATOR_NEON
+    // 1 window per iteration, widening multiply-accumulate
+    static void neon(const uint8_t *samples, size_t stride, size_t count, int *out)
+    {
+        const int16x8_t loi = vmovl_s8(vld1_s8(coeffloi.data()));
+        const int16x8_t loq = vmovl_s8(vld1_s8(coeffloq.data()));
+        const int16x8_t hii = vmovl_s8(vld1_s8(coeffhii.data()));
+        const int16x8_t hiq = vmovl_s8(vld1_s8(coeffhiq.data()));
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            const int16x8_t w = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(samples + k * stride))), vdupq_n_s16(128));
+
+            const int32x4_t s = {
+                dot_neon(w, loi),
+                dot_neon(w, loq),
+                dot_neon(w, hii),
+                dot_neon(w, hiq),
+            };
+
+            const int32x4_t sq = vmulq_s32(vshrq_n_s32(s, 8), vshrq_n_s32(s, 8));
+            out[k] = vgetq_lane_s32(sq, 2) + vgetq_lane_s32(sq, 3) - vgetq_lane_s32(sq, 0) - vgetq_lane_s32(sq, 1);
+        }
+    }
+#endif
+
+    // the fastest kernel the CPU supports
+    static kernel best()
+    {
+#if DISCRIMINATOR_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return avx2;
+        }
+
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return sse2;
+        }
+#elif DISCRIMINATOR_NEON
+        return neon;
+#endif
+        return scalar;
+    }
+
+    static void batch(const uint8_t *samples, size_t stride, size_t count, int *out)
+    {
+        static const kernel k = best();
+        k(samples, stride, count, out);
+    }
+
+  private:
+#if DISCRIMINATOR_X86
+    __attribute__((target("sse2"))) static __m128i load_coefficients_sse2(const int8_t *coeff)
+    {
+        return _mm_setr_epi16(coeff[0], coeff[1], coeff[2], coeff[3], coeff[4], coeff[5], coeff[6], coeff[7]);
+    }
+
+    // dot products of 4 windows with the same coefficients, lane j holds window j
+    __attribute__((target("sse2"))) static __m128i dot4_sse2(const __m128i *w, __m128i coeff)
+    {
+        __m128i p0 = _mm_madd_epi16(w[0], coeff);
+        __m128i p1 = _mm_madd_epi16(w[1], coeff);
+        __m128i p2 = _mm_madd_epi16(w[2], coeff);
+        __m128i p3 = _mm_madd_epi16(w[3], coeff);
+
+        // transpose and add
+        __m128i t0 = _mm_add_epi32(_mm_unpacklo_epi32(p0, p1), _mm_unpackhi_epi32(p0, p1));
+        __m128i t1 = _mm_add_epi32(_mm_unpacklo_epi32(p2, p3), _mm_unpackhi_epi32(p2, p3));
+        return _mm_add_epi32(_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1));
+    }
+
+    __attribute__((target("avx2"))) static __m256i dot4_avx2(const __m256i *w, __m256i coeff)
+    {
+        __m256i p0 = _mm256_madd_epi16(w[0], coeff);
+        __m256i p1 = _mm256_madd_epi16(w[1], coeff);
+        __m256i p2 = _mm256_madd_epi16(w[2], coeff);
+        __m256i p3 = _mm256_madd_epi16(w[3], coeff);
+
+        __m256i t0 = _mm256_add_epi32(_mm256_unpacklo_epi32(p0, p1), _mm256_unpackhi_epi32(p0, p1));
+        __m256i t1 = _mm256_add_epi32(_mm256_unpacklo_epi32(p2, p3), _mm256_unpackhi_epi32(p2, p3));
+        return _mm256_add_epi32(_mm256_unpacklo_epi64(t0, t1), _mm256_unpackhi_epi64(t0, t1));
+    }
+#endif
+
+#if DISCRIMINATOR_NEON
+    static int32_t dot_neon(int16x8_t w, int16x8_t coeff)
+    {
+        int32x4_t acc = vmull_s16(vget_low_s16(w), vget_low_s16(coeff));
+        acc = vmlal_s16(acc, vget_high_s16(w), vget_high_s16(coeff));
+        return vaddvq_s32(acc);
+    }
+#endif
+};
+
+// Runs the discriminator over every sample position of a stream fed in chunks of any size
+// The result for the window starting at sample n is produced once sample n + 7 has arrived
+class DiscriminatorStream
+{
+  public:
+    // calls on_energy(int) once per complete window, in order
+    template <typename F>
+    void feed(const uint8_t *samples, size_t count, F &&on_energy)
+    {
+        while (count)
+        {
+            const size_t n = std::min(count, block_size);
+            std::copy(samples, samples + n, buffer.begin() + carry);
+            samples += n;
+            count -= n;
+
+            const size_t total = carry + n;
+
+            if (total < Discriminator::taps)
+            {
+                carry = total;
+                continue;
+            }
+
+            const size_t windows = total - Discriminator::taps + 1;
+            Discriminator::batch(buffer.data(), 1, windows, energies.data());
+
+            for (size_t k = 0; k < windows; ++k)
+            {
+                on_energy(energies[k]);
+            }
+
+            // keep the samples of the windows that aren't complete yet
+            carry = Discriminator::taps - 1;
+            std::copy(buffer.begin() + windows, buffer.begin() + total, buffer.begin());
+        }
+    }
+
+  private:
+    static constexpr size_t block_size = 4096;
+
+    std::array<uint8_t, block_size + Discriminator::taps - 1> buffer;
+    std::array<int, block_size> energies;
+    size_t carry = 0;
+};
@@ -0,0 +1,402 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "afsk.hpp"
+#include "frontend.hpp"
+#include "metrics.hpp"
+#include "resampler.hpp"
+#include "spsc.hpp"
+
+// Decodes many channels (one radio each) at once on a pool of worker threads
+// One producer thread feeds samples through a lock-free ring per channel, every channel is owned by a single worker,
+// and decoded frames come back through a queue per channel and are merged in timestamp order
+class DecoderEngine
+{
+  public:
+    struct frame
+    {
+        size_t channel;
+
+        // input samples fed to the channel when the frame was decoded
+        uint64_t position;
+
+        std::vector<uint8_t> data;
+    };
+
+    using frame_callback = std::function<void(const frame &)>;
+
+    // samples buffered per channel, this bounds how far decoding can lag behind the input
+    static const size_t ring_size = 1 << 16;
+
+    // decoded frames waiting per channel
+    static const size_t queue_depth = 64;
+
+    // most samples a worker decodes from one channel before moving on to the next
+    static const size_t block_size = 4096;
+
+    // yields before an idle worker, or a producer facing a full ring, goes to sleep
+    static const size_t spin_rounds = 64;
+
+    // fix_bits > 0 tries to repair frames failing the FCS by flipping up to that many bits, see Framer::recover
+    // filter puts a FrontEnd (bandpass, twist equalization, AGC) in front of every channel's decoder
+    DecoderEngine(
+        size_t channels,
+        size_t sample_rate,
+        size_t threads = std::thread::hardware_concurrency(),
+        size_t fix_bits = 0,
+        bool filter = false)
+        : sample_rate(sample_rate)
+    {
+        for (size_t c = 0; c < channels; ++c)
+        {
+            this->channels.push_back(std::make_unique<channel>(c, sample_rate, fix_bits, filter));
+        }
+
+        threads = std::clamp<size_t>(threads, 1, std::max<size_t>(channels, 1));
+
+        for (size_t w = 0; w < threads; ++w)
+        {
+            idle.push_back(std::make_unique<parking>());
+        }
+
+        for (size_t c = 0; c < channels; ++c)
+        {
+            this->channels[c]->worker = idle[c % threads].get();
+        }
+
+        for (size_t w = 0; w < threads; ++w)
+        {
+            workers.emplace_back([this, w, threads] { work(w, threads); });
+        }
+    }
+
+    ~DecoderEngine()
+    {
+        finish();
+    }
+
+    // producer side, waits while the channel's ring is full
+    void feed(size_t channel, const uint8_t *samples, size_t count)
+    {
+        auto &ch = *channels[channel];
+        size_t spins = 0;
+
+        while (count)
+        {
+            const size_t n = ch.input.push(samples, count);
+
+            if (n)
+            {
+                ch.worker->wake();
+                spins = 0;
+            }
+            else if (++spins < spin_rounds)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                ch.space.sleep([&] { return ch.input.size() < ch.input.capacity(); });
+            }
+
+            samples += n;
+            count -= n;
+        }
+    }
+
+    void feed(size_t channel, const std::vector<uint8_t> &samples)
+    {
+        feed(channel, samples.data(), samples.size());
+    }
+
+    // consumer side, hands over the frames that can no longer be preceded by another one, in timestamp order
+    size_t poll(const frame_callback &on_frame)
+    {
+        uint64_t watermark = UINT64_MAX;
+
+        for (auto &ch : channels)
+        {
+            // read before draining, so no frame older than it can still be on its way
+            watermark = std::min(watermark, ch->decoded.load(std::memory_order_acquire));
+
+            frame f;
+            while (ch->output.try_pop(f))
+            {
+                pending.push_back(std::move(f));
+            }
+        }
+
+        std::stable_sort(pending.begin(), pending.end(), [](const frame &a, const frame &b) {
+            return a.position != b.position ? a.position < b.position : a.channel < b.channel;
+        });
+
+        size_t ready = 0;
+        while (ready < pending.size() && pending[ready].position <= watermark)
+        {
+            on_frame(pending[ready++]);
+        }
+
+        pending.erase(pending.begin(), pending.begin() + ready);
+        return ready;
+    }
+
+    // waits until everything fed so far is decoded and stops the workers, poll() then returns the remaining frames
+    // must be called from the thread that polls
+    void finish()
+    {
+        stopping.store(true, std::memory_order_release);
+
+        for (auto &p : idle)
+        {
+            p->wake();
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        workers.clear();
+
+        // frames the output queues had no room for
+        for (auto &ch : channels)
+        {
+            std::move(ch->produced.begin(), ch->produced.end(), std::back_inserter(pending));
+            ch->produced.clear();
+        }
+    }
+
+    size_t size() const
+    {
+        return channels.size();
+    }
+
+    double seconds(uint64_t position) const
+    {
+        return double(position) / sample_rate;
+    }
+
+    // counters of one channel, latency is the time a block of samples takes to decode
+    // safe to read from any thread while decoding
+    const Metrics &metrics(size_t channel) const
+    {
+        return channels[channel]->metrics;
+    }
+
+  private:
+    // where a thread with nothing to do sleeps until another one has something for it
+    // wake() is one fence and one load while nobody sleeps, the fences on both sides make sure a sleeper either
+    // sees what was published before wake() or gets woken
+    struct parking
+    {
+        // sleeps unless ready() holds once the sleeper is announced, at most timeout if one is given
+        template <typename Ready>
+        void sleep(Ready &&ready, std::chrono::microseconds timeout = std::chrono::microseconds::zero())
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (!ready())
+            {
+                auto woken = [this] { return !sleeping.load(std::memory_order_relaxed); };
+
+                if (timeout.count())
+                {
+                    signal.wait_for(lock, timeout, woken);
+                }
+                else
+                {
+                    signal.wait(lock, woken);
+                }
+            }
+
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        // after publishing whatever ready() looks at
+        void wake()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (sleeping.load(std::memory_order_relaxed))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    sleeping.store(false, std::memory_order_relaxed);
+                }
+
+                signal.notify_one();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable signal;
+        std::atomic<bool> sleeping = { false };
+    };
+
+    struct channel
+    {
+        channel(size_t index, size_t sample_rate, size_t fix_bits, bool filter)
+            : index(index),
+              input(ring_size),
+              output(queue_depth),
+              decoder(
+                  sample_rate,
+                  filter,
+                  [this](const std::vector<uint8_t> &data) {
+                      produced.push_back(frame{this->index, position, data});
+                  },
+                  fix_bits)
+        {
+            decoder.get().get().attach(&metrics);
+        }
+
+        // moves decoded frames to the output queue, returns false if some didn't fit
+        bool flush()
+        {
+            while (!produced.empty() && output.try_push(std::move(produced.front())))
+            {
+                produced.pop_front();
+            }
+
+            return produced.empty();
+        }
+
+        const size_t index;
+
+        SPSCRing<uint8_t> input;
+        SPSCQueue<frame> output;
+
+        // the worker owning the channel sleeps here while all its rings are empty, the producer while input is full
+        parking *worker = nullptr;
+        parking space;
+
+        Metrics metrics;
+        Resampled<Filtered<AFSK::Decoder::PLLStream>> decoder;
+
+        // input samples consumed, only touched by the owning worker
+        uint64_t position = 0;
+
+        // frames waiting for room in the output queue, so a slow consumer never stalls the worker
+        std::deque<frame> produced;
+
+        // published once all the frames up to it are queued
+        std::atomic<uint64_t> decoded = { 0 };
+    };
+
+    // worker w owns channels w, w + threads, ...
+    void work(size_t w, size_t threads)
+    {
+        size_t spins = 0;
+
+        while (true)
+        {
+            // checked before draining, so everything fed before finish() is seen
+            const bool last = stopping.load(std::memory_order_acquire);
+            bool busy = false;
+            bool backlog = false;
+
+            for (size_t c = w; c < channels.size(); c += threads)
+            {
+                auto &ch = *channels[c];
+
+                // one block per channel per round, so no channel starves the others
+                // decoded straight out of the ring
+                size_t n = block_size;
+                const uint8_t *samples = ch.input.peek(n);
+
+                if (n)
+                {
+                    const auto start = Metrics::enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+                    ch.position += n;
+                    ch.decoder.feed(samples, n);
+                    ch.input.release(n);
+                    ch.space.wake();
+                    busy = true;
+
+                    if (Metrics::enabled)
+                    {
+                        const auto elapsed = std::chrono::steady_clock::now() - start;
+                        ch.metrics.latency(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+                    }
+                }
+
+                if (ch.flush())
+                {
+                    ch.decoded.store(ch.position, std::memory_order_release);
+                }
+                else
+                {
+                    backlog = true;
+                }
+            }
+
+            if (busy)
+            {
+                spins = 0;
+                continue;
+            }
+
+            if (last)
+            {
+                break;
+            }
+
+            if (++spins < spin_rounds)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // frames the output queue had no room for are retried now and then, poll() doesn't wake workers
+            idle[w]->sleep(
+                [&] {
+                    if (stopping.load(std::memory_order_acquire))
+                    {
+                        return true;
+                    }
+
+                    for (size_t c = w; c < channels.size(); c += threads)
+                    {
+                        if (channels[c]->input.size())
+                        {
+                            return true;
+                        }
+                    }
+
+                    return false;
+                },
+                backlog ? std::chrono::milliseconds(1) : std::chrono::microseconds::zero());
+        }
+
+        // nothing more will come from this worker's channels
+        for (size_t c = w; c < channels.size(); c += threads)
+        {
+            channels[c]->decoded.store(UINT64_MAX, std::memory_order_release);
+        }
+    }
+
+    const size_t sample_rate;
+
+    std::vector<std::unique_ptr<channel>> channels;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping = { false };
+
+    // one per worker
+    std::vector<std::unique_ptr<parking>> idle;
+
+    // consumer side only
+    std::vector<frame> pending;
+};
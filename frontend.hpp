@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "afsk.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Conditions discriminator audio before demodulation, at AFSK::sample_rate
+// Bandpass FIR that also blocks DC and equalizes the mark/space twist -> AGC, all fixed point and streaming
+// De-emphasis usually leaves 2200 Hz several dB below 1200 Hz, the twist is either given or tracked from the signal
+class FrontEnd
+{
+  public:
+    // FIR length, a whole number of SIMD registers
+    static const size_t taps = 32;
+
+    // the AGC gain and the twist are updated once per block
+    static const size_t block_size = 64;
+
+    // output peak level the AGC aims for, out of 127
+    static const int target = 96;
+
+    // twist is the initial space boost in dB, adaptive keeps adjusting it so both tones come out equally loud
+    explicit FrontEnd(double twist = 0, bool adaptive = true)
+        : adaptive(adaptive),
+          space_gain(std::pow(10.0, twist / 20))
+    {
+        design();
+        update();
+    }
+
+    // filters count samples into out, which may be in
+    void process(const uint8_t *in, size_t count, uint8_t *out)
+    {
+        while (count)
+        {
+            const size_t n = std::min(count, block_size - filled);
+            int16_t *x = &line[taps - 1 + filled];
+
+            // Q6 from here on
+            for (size_t i = 0; i < n; ++i)
+            {
+                x[i] = (in[i] - 128) * 64;
+            }
+
+            // the filter only reads samples written by the loop above, never one it has just stored
+            for (size_t i = 0; i < n; ++i)
+            {
+                const int y = filter(x + i + 1 - taps);
+                filtered[filled + i] = y;
+
+                peak = std::max(peak, std::abs(y));
+                out[i] = std::clamp(128 + ((y * gain) >> 14), 0, 255);
+            }
+
+            in += n;
+            out += n;
+            count -= n;
+
+            if ((filled += n) == block_size)
+            {
+                adapt();
+            }
+        }
+    }
+
+    // space gain relative to mark, in dB
+    double twist() const
+    {
+        return 20 * std::log10(space_gain);
+    }
+
+  private:
+    // 8 taps per multiply-add, both x86-64 and AArch64 always have the instructions
+    int filter(const int16_t *x) const
+    {
+#if defined(__SSE2__)
+        __m128i acc = _mm_setzero_si128();
+
+        for (size_t j = 0; j < taps; j += 8)
+        {
+            const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + j));
+            const __m128i h = _mm_load_si128(reinterpret_cast<const __m128i *>(coeffs.data() + j));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(samples, h));
+        }
+
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        return (_mm_cvtsi128_si32(acc) + (1 << 13)) >> 14;
+#elif defined(__aarch64__)
+        int32x4_t acc = vdupq_n_s32(0);
+
+        for (size_t j = 0; j < taps; j += 4)
+        {
+            acc = vmlal_s16(acc, vld1_s16(x + j), vld1_s16(coeffs.data() + j));
+        }
+
+        return (vaddvq_s32(acc) + (1 << 13)) >> 14;
+#else
+        int acc = 1 << 13;
+
+        for (size_t j = 0; j < taps; ++j)
+        {
+            acc += x[j] * coeffs[j];
+        }
+
+        return acc >> 14;
+#endif
+    }
+
+    void adapt()
+    {
+        // the last taps - 1 samples are the history of the next block
+        std::copy(line.end() - (taps - 1), line.end(), line.begin());
+        filled = 0;
+
+        // fast attack, the envelope decays by ~1 dB per block
+        envelope = std::max(peak, envelope - envelope / 8);
+        gain = std::min(target * 256 * 64 / std::max(envelope, 1), max_gain);
+        peak = 0;
+
+        if (adaptive)
+        {
+            measure();
+        }
+    }
+
+    // Every baud-long window counts towards the level of whichever tone is stronger in it
+    // Averaging each tone only over its own windows keeps the estimate independent of how often each tone is sent
+    void measure()
+    {
+        using profile = AFSK::profile;
+
+        for (size_t k = 0; k < block_size; k += profile::taps)
+        {
+            const int *y = &filtered[k];
+            int loi = 0, loq = 0, hii = 0, hiq = 0;
+
+            for (size_t j = 0; j < profile::taps; ++j)
+            {
+                loi += y[j] * profile::coeffloi[j];
+                loq += y[j] * profile::coeffloq[j];
+                hii += y[j] * profile::coeffhii[j];
+                hiq += y[j] * profile::coeffhiq[j];
+            }
+
+            const double lo = double(loi) * loi + double(loq) * loq;
+            const double hi = double(hii) * hii + double(hiq) * hiq;
+
+            // windows holding both tones, or neither, don't count
+            if (hi > 4 * lo)
+            {
+                space_level += (hi - space_level) / 16;
+            }
+            else if (lo > 4 * hi)
+            {
+                mark_level += (lo - mark_level) / 16;
+            }
+        }
+
+        if (mark_level <= 0 || space_level <= 0)
+        {
+            return;
+        }
+
+        // closed loop: nudge the space gain towards equal output levels, within +-12 dB
+        const double ratio = std::clamp(mark_level / space_level, 0.5, 2.0);
+        space_gain = std::clamp(space_gain * (1 + (ratio - 1) / 32), 0.25, 4.0);
+        update();
+    }
+
+    // two adjacent Hamming-windowed bands, split halfway between the tones and equally wide
+    void design()
+    {
+        const double split = (AFSK::mark_freq + AFSK::space_freq) / 2.0;
+        const double low = 2 * AFSK::mark_freq - split;
+        const double high = 2 * AFSK::space_freq - split;
+        const double center = (taps - 1) / 2.0;
+
+        auto lowpass = [](double cutoff, double t) {
+            const double f = cutoff / AFSK::sample_rate;
+            return t == 0 ? 2 * f : std::sin(2 * M_PI * f * t) / (M_PI * t);
+        };
+
+        for (size_t k = 0; k < taps; ++k)
+        {
+            const double t = k - center;
+            const double hamming = 0.54 - 0.46 * std::cos(2 * M_PI * k / (taps - 1));
+
+            mark_band[k] = (lowpass(split, t) - lowpass(low, t)) * hamming;
+            space_band[k] = (lowpass(high, t) - lowpass(split, t)) * hamming;
+        }
+
+        // unity gain at the mark tone with no twist
+        double re = 0, im = 0;
+        for (size_t k = 0; k < taps; ++k)
+        {
+            const double phase = 2 * M_PI * AFSK::mark_freq * k / AFSK::sample_rate;
+            re += (mark_band[k] + space_band[k]) * std::cos(phase);
+            im += (mark_band[k] + space_band[k]) * std::sin(phase);
+        }
+
+        const double norm = 1 / std::hypot(re, im);
+        for (size_t k = 0; k < taps; ++k)
+        {
+            mark_band[k] *= norm;
+            space_band[k] *= norm;
+        }
+    }
+
+    // Q14 taps for the current twist, reversed since the filter runs from the oldest sample up
+    // The taps are made to sum to exactly zero, so the bandpass is also the DC blocker
+    void update()
+    {
+        int sum = 0;
+
+        for (size_t k = 0; k < taps; ++k)
+        {
+            coeffs[taps - 1 - k] = utils::round((mark_band[k] + space_gain * space_band[k]) * 16384);
+            sum += coeffs[taps - 1 - k];
+        }
+
+        // the rounding error goes into the two center taps
+        coeffs[taps / 2 - 1] -= sum / 2;
+        coeffs[taps / 2] -= sum - sum / 2;
+    }
+
+    // 16x, Q8
+    static constexpr int max_gain = 16 << 8;
+
+    const bool adaptive;
+    double space_gain;
+
+    std::array<double, taps> mark_band = { };
+    std::array<double, taps> space_band = { };
+    alignas(16) std::array<int16_t, taps> coeffs = { };
+
+    // taps - 1 samples of history followed by the current block
+    std::array<int16_t, taps - 1 + block_size> line = { };
+
+    // the current block after the bandpass, Q6
+    std::array<int, block_size> filtered = { };
+    size_t filled = 0;
+
+    // average energy of windows dominated by each tone
+    double mark_level = 0, space_level = 0;
+
+    int peak = 0, envelope = 0;
+
+    // Q8, times the Q6 samples gives Q14
+    int gain = 1 << 8;
+};
+
+// Puts a front end in front of any decoder with a feed(const uint8_t *, size_t) method
+// A disabled one hands samples straight through
+template <typename Decoder>
+class Filtered
+{
+  public:
+    template <typename... Args>
+    Filtered(bool enabled, Args &&...args)
+        : enabled(enabled),
+          decoder(std::forward<Args>(args)...)
+    {
+    }
+
+    void feed(const uint8_t *samples, size_t count)
+    {
+        if (!enabled)
+        {
+            decoder.feed(samples, count);
+            return;
+        }
+
+        while (count)
+        {
+            const size_t n = std::min(count, buffer.size());
+            frontend.process(samples, n, buffer.data());
+            decoder.feed(buffer.data(), n);
+            samples += n;
+            count -= n;
+        }
+    }
+
+    void feed(const std::vector<uint8_t> &samples)
+    {
+        feed(samples.data(), samples.size());
+    }
+
+    Decoder &get()
+    {
+        return decoder;
+    }
+
+    FrontEnd &front()
+    {
+        return frontend;
+    }
+
+  private:
+    const bool enabled;
+
+    FrontEnd frontend;
+    Decoder decoder;
+    std::array<uint8_t, 4096> buffer;
+};
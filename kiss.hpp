@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// KISS framing between a TNC and its host, as in the KA9Q/K3MC spec
+// A frame is FEND, a type byte (port in the high nibble, command in the low one), the escaped payload, FEND
+// Payloads are AX.25 frames without flags and without the FCS
+namespace KISS
+{
+static const uint8_t FEND = 0xC0;
+static const uint8_t FESC = 0xDB;
+static const uint8_t TFEND = 0xDC;
+static const uint8_t TFESC = 0xDD;
+
+enum Command : uint8_t
+{
+    DATA = 0x00,
+    TXDELAY = 0x01,
+    PERSISTENCE = 0x02,
+    SLOT_TIME = 0x03,
+    TXTAIL = 0x04,
+    FULL_DUPLEX = 0x05,
+    SET_HARDWARE = 0x06,
+    RETURN = 0x0F,
+};
+
+// TXDELAY and TXTAIL are given in units of 10 ms
+static const size_t time_unit_ms = 10;
+
+// appends one escaped frame to out, the payload is copied in runs between the bytes that need escaping
+inline void Encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out, uint8_t port = 0, Command command = DATA)
+{
+    out.push_back(FEND);
+    out.push_back(uint8_t(port << 4) | command);
+
+    const uint8_t *end = data + size;
+
+    while (data != end)
+    {
+        const uint8_t *run = data;
+        while (run != end && *run != FEND && *run != FESC)
+        {
+            ++run;
+        }
+
+        out.insert(out.end(), data, run);
+
+        if (run != end)
+        {
+            out.push_back(FESC);
+            out.push_back(*run == FEND ? TFEND : TFESC);
+            ++run;
+        }
+
+        data = run;
+    }
+
+    out.push_back(FEND);
+}
+
+inline void Encode(const std::vector<uint8_t> &data, std::vector<uint8_t> &out, uint8_t port = 0, Command command = DATA)
+{
+    Encode(data.data(), data.size(), out, port, command);
+}
+
+// Splits a byte stream into frames, whatever way it was chunked
+// Bytes before the first FEND are dropped, as are empty frames and ones longer than max_size
+class Decoder
+{
+  public:
+    explicit Decoder(size_t max_size = 1024)
+        : max_size(max_size)
+    {
+        frame.reserve(max_size + 1);
+    }
+
+    // calls on_frame(port, command, payload, size) for every complete frame
+    template <typename Callback>
+    void feed(const uint8_t *data, size_t size, Callback &&on_frame)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const uint8_t c = data[i];
+
+            if (c == FEND)
+            {
+                // a lone type byte is still a frame, e.g. RETURN
+                if (synced && !overflow && !frame.empty())
+                {
+                    on_frame(frame[0] >> 4, Command(frame[0] & 0x0F), frame.data() + 1, frame.size() - 1);
+                }
+
+                synced = true;
+                escaped = false;
+                overflow = false;
+                frame.clear();
+                continue;
+            }
+
+            if (!synced || overflow)
+            {
+                continue;
+            }
+
+            if (escaped)
+            {
+                // anything but TFEND and TFESC after FESC is a protocol error, the spec keeps the byte
+                escaped = false;
+                push(c == TFEND ? FEND : c == TFESC ? FESC : c);
+            }
+            else if (c == FESC)
+            {
+                escaped = true;
+            }
+            else
+            {
+                push(c);
+            }
+        }
+    }
+
+  private:
+    void push(uint8_t c)
+    {
+        // the type byte doesn't count towards the payload
+        if (frame.size() > max_size)
+        {
+            overflow = true;
+            return;
+        }
+
+        frame.push_back(c);
+    }
+
+    const size_t max_size;
+
+    std::vector<uint8_t> frame;
+    bool synced = false;
+    bool escaped = false;
+    bool overflow = false;
+};
+}
@@ -1,15 +1,26 @@
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <functional>
+#include <future>
 #include <cmath>
+#include <thread>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "utils.hpp"
 #include "aprs.hpp"
+#include "dedupe.hpp"
+#include "engine.hpp"
 #include "afsk.hpp"
+#include "metrics.hpp"
 #include "wav.hpp"
+#include "phase_search.hpp"
+#include "resampler.hpp"
 #include "stack_guards.hpp"
+#include "tnc.hpp"
 
 using namespace std::literals;
 
@@ -35,24 +46,24 @@ void aprs_test(
     }
     std::cout << std::endl;
 
-    auto samples = AFSK::Encoder::Encode(packet);
+    // a few flags of preamble, like any real transmitter, so the decoder can sync
+    auto samples = AFSK::Encoder::Encode(packet, 4, 4);
 
     {
         WAVWriter ww(out_wav, AFSK::sample_rate);
-        for (auto sample : samples)
-        {
-            ww.put(sample);
-        }
+        ww.put(samples);
+        ww.close();
     }
 
     WAVReader wr(out_wav);
+    const std::vector<uint8_t> written(wr.Data(), wr.Data() + wr.Size());
 
     std::multimap<bool, int> phase_shift_result;
     std::multimap<bool, int> decode_result;
 
     for (size_t shift = 0; shift < AFSK::sample_rate / AFSK::baud_rate; ++shift)
     {
-        auto result = AFSK::Decoder::demod(wr.Samples(), shift);
+        auto result = AFSK::Decoder::demod(written, shift);
 
         if (packet.size() > result.size())
         {
@@ -91,16 +102,255 @@ void aprs_test(
     END();
 }
 
-void decode_file()
+// the same frame arrives from several slicers and digipeaters, APRS treats repeats within 30 s as duplicates
+static const uint64_t dupe_window = 30;
+
+// frames failing the FCS get up to 2 of their least confident bits flipped, which saves a good share of weak ones
+static const size_t fix_bits = 2;
+
+// real receivers leave the tones at different levels and wander off DC, the engine's channels are conditioned first
+static const bool front_end = true;
+
+// with -m the counters go to stderr this often, and once more at the end
+static const auto metrics_interval = 10s;
+
+void dump_metrics(const std::vector<const Metrics *> &channels)
+{
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        channels[c]->snapshot().dump(std::cerr, "[" + std::to_string(c) + "]");
+    }
+}
+
+// the single pass decoders hand over whatever sits between two flags, only the first valid copy is kept
+bool accept_frame(const std::vector<uint8_t> &frame, DupeCache<> &dupes, uint64_t now)
+{
+    AX25FrameView view(frame.data(), frame.size());
+    return view.IsValid() && view.HasValidFCS() && !dupes.Check(view, now);
+}
+
+void print_frame(const std::vector<uint8_t> &frame, const std::string &prefix = "")
+{
+    AX25FrameView view(frame.data(), frame.size());
+    const auto source = view.Source();
+    std::cout << prefix << source.callsign() << '-' << int(source.ssid) << ": " << view.Info() << std::endl;
+}
+
+// every channel is a radio of its own, decoded on the engine's worker threads
+// on_frame gets the frames that pass accept_frame
+template <typename Reader, typename Handler>
+void decode_channels(Reader &&read, const WAVFormat &format, bool metrics, Handler &&on_frame)
 {
-    WAVReader wr("test.wav");
-    auto result = AFSK::Decoder::demod(wr.Samples(), 0);
-    auto decoded = APRSPacket::Decode(result);
+    DupeCache<> dupes(dupe_window * format.sample_rate);
+    DecoderEngine engine(format.channels, format.sample_rate, std::thread::hardware_concurrency(), fix_bits, front_end);
+
+    auto deliver = [&](const DecoderEngine::frame &f) {
+        if (accept_frame(f.data, dupes, f.position))
+        {
+            on_frame(f);
+        }
+    };
+
+    std::vector<std::vector<uint8_t>> blocks(format.channels, std::vector<uint8_t>(WAVStreamReader::block_frames));
+    std::vector<uint8_t *> out(WAVFormat::max_channels);
+
+    std::vector<const Metrics *> counters;
+
+    for (size_t c = 0; c < blocks.size(); ++c)
+    {
+        out[c] = blocks[c].data();
+        counters.push_back(&engine.metrics(c));
+    }
+
+    auto next_dump = std::chrono::steady_clock::now() + metrics_interval;
+
+    while (size_t count = read(out.data(), WAVStreamReader::block_frames))
+    {
+        for (size_t c = 0; c < blocks.size(); ++c)
+        {
+            engine.feed(c, blocks[c].data(), count);
+        }
+
+        engine.poll(deliver);
+
+        if (metrics && std::chrono::steady_clock::now() >= next_dump)
+        {
+            dump_metrics(counters);
+            next_dump += metrics_interval;
+        }
+    }
+
+    engine.finish();
+    engine.poll(deliver);
+
+    if (metrics)
+    {
+        dump_metrics(counters);
+    }
+}
+
+// decodes all channels of a WAV file, "-" reads stdin
+void decode_file(const std::string &name, bool metrics)
+{
+    auto print = [](const DecoderEngine::frame &f, size_t channels) {
+        print_frame(f.data, channels > 1 ? "[" + std::to_string(f.channel) + "] " : "");
+    };
+
+    if (name == "-")
+    {
+        WAVStreamReader sr(name);
+        decode_channels(
+            [&](uint8_t *const *out, size_t count) { return sr.Read(out, count); },
+            sr.Format(),
+            metrics,
+            [&](const DecoderEngine::frame &f) { print(f, sr.Format().channels); });
+        return;
+    }
+
+    WAVReader wr(name);
+
+    // the phase is unknown for real recordings, so all of them are searched - straight from the mapped file
+    if (wr.IsNative() && wr.Format().sample_rate == AFSK::sample_rate)
+    {
+        DupeCache<> dupes(dupe_window * wr.Format().sample_rate);
+        Metrics counters;
+
+        auto decoding = std::async(std::launch::async, [&] {
+            return PhaseSearchDecoder::decode(wr.Data(), wr.Size(), std::thread::hardware_concurrency(), fix_bits, &counters);
+        });
+
+        // the counters are safe to read while the decoding threads update them
+        while (decoding.wait_for(metrics_interval) != std::future_status::ready)
+        {
+            if (metrics)
+            {
+                dump_metrics({&counters});
+            }
+        }
+
+        for (const auto &frame : decoding.get())
+        {
+            if (accept_frame(frame.data, dupes, frame.end))
+            {
+                print_frame(frame.data);
+            }
+        }
+
+        if (metrics)
+        {
+            dump_metrics({&counters});
+        }
+
+        return;
+    }
+
+    size_t first = 0;
+    decode_channels(
+        [&](uint8_t *const *out, size_t count) {
+            size_t got = 0;
+            for (size_t c = 0; c < wr.Format().channels; ++c)
+            {
+                got = wr.Read(c, first, count, out[c]);
+            }
+
+            first += got;
+            return got;
+        },
+        wr.Format(),
+        metrics,
+        [&](const DecoderEngine::frame &f) { print(f, wr.Format().channels); });
+}
+
+// KISS TNC: frames decoded from in go to every host, channel n as KISS port n
+// frames from the hosts are transmitted into out, one transmission per batch, and flushed right away
+// keeps running after in ends, so hosts can still transmit, until SIGINT or SIGTERM
+// returns false if decoding in failed
+bool run_tnc(const std::string &in, const std::string &out, const std::string &where)
+{
+    WAVWriter ww(out, AFSK::sample_rate);
+    std::vector<uint8_t> audio;
+
+    // shared with the receiver, which may still be blocked reading in when the loop is done
+    const auto tnc = std::make_shared<TNC>([&](const std::vector<TNC::frame> &frames, const AFSK::Encoder::tx_options &options) {
+        size_t flags = options.txdelay + options.txtail, bytes = 0;
+        for (const auto &f : frames)
+        {
+            flags += options.gap + 1;
+            bytes += f.data.size();
+        }
+
+        // every port shares the one output
+        audio.resize(AFSK::Encoder::max_samples(flags, bytes));
+        AFSK::Encoder::Transmission<> tx(audio.data(), audio.size(), options);
+
+        for (const auto &f : frames)
+        {
+            tx.add(f.data);
+        }
+
+        ww.put(audio.data(), tx.finish());
+        ww.flush();
+    });
+
+    if (where == "pty")
+    {
+        std::cerr << "KISS TNC on " << tnc->open_pty() << std::endl;
+    }
+    else
+    {
+        const int port = std::atoi(where.c_str());
+        if (port <= 0 || port > 65535)
+        {
+            throw EXCEPTION("Bad port " + where);
+        }
+
+        tnc->listen(port);
+        std::cerr << "KISS TNC on 127.0.0.1:" << port << std::endl;
+    }
+
+    const auto failed = std::make_shared<std::atomic<bool>>(false);
+
+    // detached: nothing interrupts a blocking read, and the process is on its way out once the loop is done
+    std::thread([tnc, failed, in] {
+        try
+        {
+            WAVStreamReader sr(in);
+            decode_channels(
+                [&](uint8_t *const *out, size_t count) { return sr.Read(out, count); },
+                sr.Format(),
+                false,
+                [&](const DecoderEngine::frame &f) { tnc->send(f.channel, f.data); });
+
+            std::cerr << "End of " << in << ", transmitting only" << std::endl;
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            *failed = true;
+            tnc->stop();
+        }
+    }).detach();
+
+    // the transmit callback only runs in here, so ww can get its final header once it returns
+    tnc->run();
+    ww.close();
+    return !*failed;
 }
 
 int main(int argc, char *argv[])
 {
     BEGIN();
+    if ((argc == 3 || (argc == 4 && argv[3] == "-m"s)) && argv[1] == "-d"s)
+    {
+        decode_file(argv[2], argc == 4);
+        return 0;
+    }
+
+    if (argc == 5 && argv[1] == "-k"s)
+    {
+        return run_tnc(argv[2], argv[3], argv[4]) ? 0 : 1;
+    }
+
     if (argc < 4)
     {
         std::cerr
@@ -110,7 +360,15 @@ int main(int argc, char *argv[])
             << "callsign: sender callsign\n"
             << "cs_suffix: sender SSID, number, 1-15\n"
             << "message: the actual message to send, spaces are allowed, no quotes required\n"
-            << "out: output .wav file name\n";
+            << "out: output .wav file name\n"
+            << "\n"
+            << "-d <in> [-m]\n"
+            << "in: .wav file to decode, every channel separately, - for stdin\n"
+            << "-m: print decoder counters to stderr every 10 s and at the end\n"
+            << "\n"
+            << "-k <in> <out> <port>\n"
+            << "KISS TNC: decodes in (.wav, - for stdin) for hosts on 127.0.0.1:port, or on a new pty if port is pty,\n"
+            << "and writes what they send as .wav to out (- for stdout)\n";
         return 1;
     }
 
@@ -121,9 +379,7 @@ int main(int argc, char *argv[])
         message.push_back(' ');
     }
 
-    //aprs_test(argv[1], std::atoi(argv[2]), message, argv[argc - 1]);
-
-    decode_file();
+    aprs_test(argv[1], std::atoi(argv[2]), message, argv[argc - 1]);
 
     END_AND_CATCH(ex)
     {
@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Build with -DAPRS_METRICS=0 to compile every counter update out, e.g. for benchmarks
+#ifndef APRS_METRICS
+#define APRS_METRICS 1
+#endif
+
+// Decoder and codec counters, one instance per channel or caller, each on cache lines of its own
+// Updates are relaxed atomic adds, made per batch of samples, flag or frame - never per sample
+// Threads sharing a channel count into shards of its instance, merged when a snapshot is taken
+// Any thread may take a snapshot at any time, counters are monotonic so two snapshots subtract into rates
+class alignas(64) Metrics
+{
+  public:
+    static constexpr bool enabled = APRS_METRICS;
+
+    enum Counter : size_t
+    {
+        SAMPLES,
+        FLAGS,
+        FRAMES,
+        FCS_FAILURES,
+        STUFFING_ERRORS,
+        RECOVERED,
+        ENCODED,
+        DECODED,
+        CODEC_ERRORS,
+        COUNTERS,
+    };
+
+    // latency bucket b counts durations of [2^(b-1), 2^b) microseconds, the last one everything longer
+    static const size_t latency_buckets = 16;
+
+    struct Snapshot
+    {
+        std::array<uint64_t, COUNTERS> counters = { };
+        std::array<uint64_t, latency_buckets> latency = { };
+
+        uint64_t operator[](Counter c) const
+        {
+            return counters[c];
+        }
+
+        // what happened between two snapshots
+        Snapshot operator-(const Snapshot &earlier) const
+        {
+            Snapshot d;
+            for (size_t i = 0; i < COUNTERS; ++i)
+            {
+                d.counters[i] = counters[i] - earlier.counters[i];
+            }
+            for (size_t i = 0; i < latency_buckets; ++i)
+            {
+                d.latency[i] = latency[i] - earlier.latency[i];
+            }
+            return d;
+        }
+
+        // one line of name=value pairs, nonzero counters first, then the latency histogram
+        void dump(std::ostream &out, const std::string &label = "") const
+        {
+            const char *separator = label.empty() ? "" : " ";
+            out << label;
+
+            for (size_t i = 0; i < COUNTERS; ++i)
+            {
+                if (counters[i])
+                {
+                    out << separator << name(Counter(i)) << '=' << counters[i];
+                    separator = " ";
+                }
+            }
+
+            for (size_t i = 0; i < latency_buckets; ++i)
+            {
+                if (latency[i])
+                {
+                    out << separator << "latency<" << (i + 1 < latency_buckets ? std::to_string(1u << i) + "us" : "inf")
+                        << '=' << latency[i];
+                    separator = " ";
+                }
+            }
+
+            out << '\n';
+        }
+    };
+
+    void add(Counter c, uint64_t n = 1)
+    {
+        if constexpr (enabled)
+        {
+            counters[c].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    void latency(uint64_t microseconds)
+    {
+        if constexpr (enabled)
+        {
+            size_t bucket = 0;
+            while (microseconds && bucket + 1 < latency_buckets)
+            {
+                microseconds >>= 1;
+                ++bucket;
+            }
+
+            histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot s;
+        for (size_t i = 0; i < COUNTERS; ++i)
+        {
+            s.counters[i] = counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < latency_buckets; ++i)
+        {
+            s.latency[i] = histogram[i].load(std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(shards_lock);
+        for (const auto &shard : shards)
+        {
+            const Snapshot t = shard->snapshot();
+            for (size_t i = 0; i < COUNTERS; ++i)
+            {
+                s.counters[i] += t.counters[i];
+            }
+            for (size_t i = 0; i < latency_buckets; ++i)
+            {
+                s.latency[i] += t.latency[i];
+            }
+        }
+        return s;
+    }
+
+    static const char *name(Counter c)
+    {
+        static const char *const names[COUNTERS] = {
+            "samples",
+            "flags",
+            "frames",
+            "fcs_failures",
+            "stuffing_errors",
+            "recovered",
+            "encoded",
+            "decoded",
+            "codec_errors",
+        };
+
+        return names[c];
+    }
+
+    // a child for one more thread counting the same thing, so threads don't contend on one set of counters
+    // it lives as long as this instance and is merged into its snapshots
+    Metrics &shard()
+    {
+        std::lock_guard<std::mutex> lock(shards_lock);
+        shards.push_back(std::make_unique<Metrics>());
+        return *shards.back();
+    }
+
+  private:
+    std::array<std::atomic<uint64_t>, COUNTERS> counters = { };
+    std::array<std::atomic<uint64_t>, latency_buckets> histogram = { };
+
+    mutable std::mutex shards_lock;
+    std::vector<std::unique_ptr<Metrics>> shards;
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "utils.hpp"
+
+// Output sample formats of the synthesizer, from a signed 16-bit value
+template <typename T>
+struct SampleFormat;
+
+template <>
+struct SampleFormat<uint8_t>
+{
+    static uint8_t convert(int value)
+    {
+        return 128 + (value >> 8);
+    }
+};
+
+template <>
+struct SampleFormat<int16_t>
+{
+    static int16_t convert(int value)
+    {
+        return value;
+    }
+};
+
+template <>
+struct SampleFormat<float>
+{
+    static float convert(int value)
+    {
+        return value * (1.0f / 32768);
+    }
+};
+
+// Phase-continuous numerically controlled oscillator
+// A 32-bit phase accumulator wraps once per cycle, so tones are exact to sample_rate / 2^32 Hz at any output rate
+// The top bits of the phase index a power-of-two sine table, the next 16 interpolate between neighbouring entries
+class NCO
+{
+  public:
+    static constexpr int table_bits = 10;
+    static constexpr size_t table_size = size_t(1) << table_bits;
+
+    // amplitude is relative to full scale of the output format
+    explicit NCO(size_t sample_rate, double amplitude = 1.0)
+        : sample_rate(sample_rate),
+          gain(utils::round(amplitude * 32767))
+    {
+    }
+
+    // phase increment per sample for a tone
+    uint32_t step(double freq) const
+    {
+        return static_cast<uint32_t>(utils::round(freq * 4294967296.0 / sample_rate));
+    }
+
+    // changes the frequency without a phase jump
+    void tune(uint32_t delta)
+    {
+        increment = delta;
+    }
+
+    uint32_t phase() const
+    {
+        return accumulator;
+    }
+
+    // next sample, full scale is +-32767
+    int next()
+    {
+        const uint32_t index = accumulator >> (32 - table_bits);
+        const int fraction = (accumulator >> (16 - table_bits)) & 0xFFFF;
+        accumulator += increment;
+
+        const int a = table[index];
+        const int b = table[index + 1];
+        const int value = a + (((b - a) * fraction) >> 16);
+
+        return (value * gain) >> 15;
+    }
+
+    // writes count samples, returns the end of the written range
+    template <typename T>
+    T *generate(T *out, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = SampleFormat<T>::convert(next());
+        }
+
+        return out + count;
+    }
+
+  private:
+    static constexpr auto table = utils::sine_table<table_size>();
+
+    size_t sample_rate;
+    int gain;
+
+    uint32_t accumulator = 0;
+    uint32_t increment = 0;
+};
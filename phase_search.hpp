@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "afsk.hpp"
+#include "aprs.hpp"
+#include "discriminator.hpp"
+
+// Decodes all sample phases at once ("multiple slicers")
+// The discriminator runs once per sample position, then each phase slices every window_size-th result
+// Only frames with a valid FCS are reported, and a frame found by several phases is reported once
+class PhaseSearchDecoder
+{
+  public:
+    static const size_t window = AFSK::Decoder::window_size;
+    static const size_t phases = window;
+
+    // longest a frame can last on air: at most 1 in 6 bits is stuffed, plus a few flags
+    static const size_t max_frame_samples = (AFSK::Decoder::max_frame_size * 8 * 6 / 5 + 32) * window;
+
+    struct frame
+    {
+        std::vector<uint8_t> data;
+
+        // phase that decoded the frame first
+        size_t phase;
+
+        // sample position right after the closing flag
+        uint64_t end;
+    };
+
+    using frame_callback = std::function<void(const frame &)>;
+
+    // position is the absolute index of the first sample fed, so phases stay comparable between decoders
+    // fix_bits > 0 tries to repair frames failing the FCS by flipping up to that many bits, see Framer::recover
+    PhaseSearchDecoder(frame_callback on_frame, uint64_t position = 0, size_t fix_bits = 0)
+        : on_frame(std::move(on_frame)),
+          position(position),
+          fix_bits(fix_bits)
+    {
+    }
+
+    void feed(const uint8_t *samples, size_t count)
+    {
+        if (metrics)
+        {
+            metrics->add(Metrics::SAMPLES, count);
+        }
+
+        // one correlation per sample position, shared by all slicers
+        correlator.feed(samples, count, [this](int energy) {
+            slice(energy);
+            ++position;
+        });
+    }
+
+    void feed(const std::vector<uint8_t> &samples)
+    {
+        feed(samples.data(), samples.size());
+    }
+
+    // number of valid frames (duplicates included) each phase has decoded
+    const std::array<size_t, phases> &votes() const
+    {
+        return phase_votes;
+    }
+
+    // the phase that decoded the most valid frames so far
+    size_t best_phase() const
+    {
+        return std::max_element(phase_votes.begin(), phase_votes.end()) - phase_votes.begin();
+    }
+
+    // frames that failed the FCS check on any phase, and could not be repaired
+    size_t rejected() const
+    {
+        return fcs_failures;
+    }
+
+    // frames that only passed the FCS after flipping bits, duplicates included
+    size_t recovered() const
+    {
+        return fcs_recovered;
+    }
+
+    // counts into metrics from now on, as one decoder: every reported frame once, flags and FCS failures as the
+    // best phase so far sees them, the others would only count the same ones again
+    void attach(Metrics *metrics)
+    {
+        slicers[reference].attach(nullptr);
+        this->metrics = metrics;
+        slicers[reference].attach(metrics, false);
+    }
+
+    // decodes a whole recording, splitting it between threads
+    // segments overlap by the longest possible frame so frames crossing a boundary aren't lost
+    // all threads count into shards of metrics if given, each segment from its own start, so overlaps count once
+    static std::vector<frame> decode(
+        const uint8_t *samples,
+        size_t count,
+        size_t threads = std::thread::hardware_concurrency(),
+        size_t fix_bits = 0,
+        Metrics *metrics = nullptr)
+    {
+        threads = std::max<size_t>(threads, 1);
+        const size_t segment = (count + threads - 1) / threads;
+
+        std::vector<std::vector<frame>> results(threads);
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads && t * segment < count; ++t)
+        {
+            const size_t begin = t * segment;
+            const size_t end = std::min(count, begin + segment);
+            Metrics *shard = metrics ? &metrics->shard() : nullptr;
+
+            workers.emplace_back([&, t, begin, end, shard] {
+                const size_t from = begin > max_frame_samples ? begin - max_frame_samples : 0;
+
+                // a segment owns the frames ending inside it
+                PhaseSearchDecoder decoder(
+                    [&](const frame &f) {
+                        if (f.end > begin && f.end <= end)
+                        {
+                            results[t].push_back(f);
+                        }
+                    },
+                    from,
+                    fix_bits);
+
+                decoder.feed(samples + from, begin - from);
+                decoder.attach(shard);
+                decoder.feed(samples + begin, end - begin);
+            });
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        std::vector<frame> merged;
+
+        for (auto &result : results)
+        {
+            for (auto &f : result)
+            {
+                // segments may disagree on where exactly a frame crossing their boundary ended
+                if (!merged.empty() && is_duplicate(merged.back(), f))
+                {
+                    continue;
+                }
+
+                merged.push_back(std::move(f));
+            }
+        }
+
+        return merged;
+    }
+
+    static std::vector<frame> decode(
+        const std::vector<uint8_t> &samples,
+        size_t threads = std::thread::hardware_concurrency(),
+        size_t fix_bits = 0,
+        Metrics *metrics = nullptr)
+    {
+        return decode(samples.data(), samples.size(), threads, fix_bits, metrics);
+    }
+
+  private:
+    // all phases see the closing flag within a baud or two of each other,
+    // while two genuine copies of a frame are at least a frame apart
+    static const size_t dedupe_distance = 4 * window;
+
+    static bool is_duplicate(const frame &a, const frame &b)
+    {
+        const uint64_t distance = a.end > b.end ? a.end - b.end : b.end - a.end;
+        return distance <= dedupe_distance && a.data == b.data;
+    }
+
+    void slice(int energy)
+    {
+        const size_t phase = position % phases;
+        auto &slicer = slicers[phase];
+
+        if (!slicer.push(energy))
+        {
+            return;
+        }
+
+        const auto &data = slicer.frame();
+
+        const bool valid = APRSPacket::CheckFCS(data.data(), data.size());
+
+        if (!valid && (!fix_bits || !slicer.recover(fix_bits)))
+        {
+            ++fcs_failures;
+
+            if (metrics && phase == reference)
+            {
+                metrics->add(Metrics::FRAMES);
+                metrics->add(Metrics::FCS_FAILURES);
+            }
+
+            return;
+        }
+
+        fcs_recovered += !valid;
+        ++phase_votes[phase];
+
+        // flags are counted on the best phase, following it as the votes change
+        if (metrics && phase_votes[phase] > phase_votes[reference])
+        {
+            slicers[reference].attach(nullptr);
+            reference = phase;
+            slicer.attach(metrics, false);
+        }
+
+        frame &slot = recent[next_recent];
+        const uint64_t end = position + window;
+
+        for (const auto &r : recent)
+        {
+            if (!r.data.empty() && end - r.end <= dedupe_distance && r.data == data)
+            {
+                return;
+            }
+        }
+
+        // reuses the slot's storage
+        slot.data.assign(data.begin(), data.end());
+        slot.phase = phase;
+        slot.end = end;
+        next_recent = (next_recent + 1) % recent.size();
+
+        if (metrics)
+        {
+            metrics->add(Metrics::FRAMES);
+
+            if (!valid)
+            {
+                metrics->add(Metrics::RECOVERED);
+            }
+        }
+
+        on_frame(slot);
+    }
+
+    frame_callback on_frame;
+
+    std::array<AFSK::Decoder::Framer, phases> slicers;
+    std::array<size_t, phases> phase_votes = { };
+    size_t fcs_failures = 0;
+    size_t fcs_recovered = 0;
+
+    // recently reported frames, for dedupe
+    std::array<frame, phases> recent = { };
+    size_t next_recent = 0;
+
+    // absolute position of the window currently being sliced
+    uint64_t position;
+
+    size_t fix_bits;
+    Metrics *metrics = nullptr;
+
+    // the slicer counting flags into metrics
+    size_t reference = 0;
+
+    DiscriminatorStream correlator;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+
+#include "utils.hpp"
+
+// Modem profile: sample rate, baud rate and the two tones
+// All correlator tables are generated at compile time, and the window kernel is fully unrolled per profile
+template <size_t SampleRate, size_t BaudRate, size_t MarkFreq, size_t SpaceFreq>
+struct AFSKProfile
+{
+    static_assert(SampleRate % BaudRate == 0, "a baud must span a whole number of samples");
+    static_assert(2 * MarkFreq < SampleRate && 2 * SpaceFreq < SampleRate, "tones must be below Nyquist");
+
+    static constexpr size_t sample_rate = SampleRate;
+    static constexpr size_t baud_rate = BaudRate;
+    static constexpr size_t mark_freq = MarkFreq;
+    static constexpr size_t space_freq = SpaceFreq;
+
+    // samples per baud, which is also the correlation window
+    static constexpr size_t taps = SampleRate / BaudRate;
+
+    // both tones complete a whole number of cycles in this many samples
+    static constexpr size_t period = std::lcm(
+        SampleRate / std::gcd(SampleRate, MarkFreq),
+        SampleRate / std::gcd(SampleRate, SpaceFreq));
+
+    // 64 * cos/sin of the tone phase at sample n
+    template <size_t N>
+    static constexpr std::array<int8_t, N> table(size_t freq, bool quadrature)
+    {
+        std::array<int8_t, N> t = { };
+        for (size_t n = 0; n < N; ++n)
+        {
+            const double phase = 2 * utils::pi * freq * n / SampleRate;
+            t[n] = utils::round(64 * (quadrature ? utils::sin(phase) : utils::cos(phase)));
+        }
+        return t;
+    }
+
+    // window-relative tables, used by window()
+    static constexpr auto coeffloi = table<taps>(MarkFreq, false);
+    static constexpr auto coeffloq = table<taps>(MarkFreq, true);
+    static constexpr auto coeffhii = table<taps>(SpaceFreq, false);
+    static constexpr auto coeffhiq = table<taps>(SpaceFreq, true);
+
+    // absolute-phase tables, used by the sliding correlator
+    static constexpr auto phaseloi = table<period>(MarkFreq, false);
+    static constexpr auto phaseloq = table<period>(MarkFreq, true);
+    static constexpr auto phasehii = table<period>(SpaceFreq, false);
+    static constexpr auto phasehiq = table<period>(SpaceFreq, true);
+
+    // space minus mark energy of one baud starting at data, > 0 means space
+    static int window(const uint8_t *data)
+    {
+        return window(data, std::make_index_sequence<taps>());
+    }
+
+  private:
+    template <size_t... I>
+    static int window(const uint8_t *data, std::index_sequence<I...>)
+    {
+        const int outloi = (0 + ... + ((data[I] - 128) * coeffloi[I]));
+        const int outloq = (0 + ... + ((data[I] - 128) * coeffloq[I]));
+        const int outhii = (0 + ... + ((data[I] - 128) * coeffhii[I]));
+        const int outhiq = (0 + ... + ((data[I] - 128) * coeffhiq[I]));
+
+        return (outhii >> 8) * (outhii >> 8) + (outhiq >> 8) * (outhiq >> 8) -
+               (outloi >> 8) * (outloi >> 8) - (outloq >> 8) * (outloq >> 8);
+    }
+};
+
+// 1200 baud VHF packet, the APRS default
+using Bell202 = AFSKProfile<9600, 1200, 1200, 2200>;
+
+// 300 baud HF packet, 200 Hz shift
+using HF300 = AFSKProfile<4800, 300, 1600, 1800>;
+
+// 2400 baud AFSK as used by Dire Wolf
+using AFSK2400 = AFSKProfile<19200, 2400, 2165, 3970>;
+
+// Sliding-window counterpart of AFSKProfile::window
+// Keeps running I/Q sums for both tones, so the discriminator is known for every sample position at O(1) cost
+template <typename Profile>
+class ToneCorrelator
+{
+  public:
+    // pushes one sample, returns the discriminator for the window ending with it
+    // same scale as Profile::window
+    int push(uint8_t sample)
+    {
+        constexpr size_t taps = Profile::taps;
+        constexpr size_t period = Profile::period;
+
+        const int in = sample - 128;
+        const int out = history[pos];
+        history[pos] = in;
+        pos = pos + 1 == taps ? 0 : pos + 1;
+
+        // phase of the sample leaving the window
+        const size_t old = phase >= taps % period ? phase - taps % period : phase + period - taps % period;
+
+        loi += in * Profile::phaseloi[phase] - out * Profile::phaseloi[old];
+        loq += in * Profile::phaseloq[phase] - out * Profile::phaseloq[old];
+        hii += in * Profile::phasehii[phase] - out * Profile::phasehii[old];
+        hiq += in * Profile::phasehiq[phase] - out * Profile::phasehiq[old];
+
+        if (++phase == period)
+        {
+            phase = 0;
+        }
+
+        return (hii >> 8) * (hii >> 8) + (hiq >> 8) * (hiq >> 8) -
+               (loi >> 8) * (loi >> 8) - (loq >> 8) * (loq >> 8);
+    }
+
+    // correlates a whole block, out[i] corresponds to the window ending with samples[i]
+    void process(const uint8_t *samples, size_t count, int *out)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = push(samples[i]);
+        }
+    }
+
+  private:
+    std::array<int, Profile::taps> history = { };
+    size_t pos = 0;
+    size_t phase = 0;
+
+    int loi = 0, loq = 0, hii = 0, hiq = 0;
+};
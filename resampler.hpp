@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "afsk.hpp"
+
+// Streaming rational-rate polyphase resampler for unsigned 8-bit samples
+// Converts any input rate to the rate the demodulators expect (or any other)
+// Only the filter phases that produce an output sample are ever computed
+class Resampler
+{
+  public:
+    // taps_per_phase = 0 picks a filter long enough for the decimation ratio
+    Resampler(size_t input_rate, size_t output_rate = AFSK::sample_rate, size_t taps_per_phase = 0)
+        : up(output_rate / std::gcd(input_rate, output_rate)),
+          down(input_rate / std::gcd(input_rate, output_rate)),
+          taps(taps_per_phase ? taps_per_phase : 16 * ((down + up - 1) / up)),
+          coeffs(up * taps),
+          history(2 * taps, 0)
+    {
+        design();
+    }
+
+    // upper bound of samples produced from count input samples
+    size_t max_output(size_t count) const
+    {
+        return count * up / down + 1;
+    }
+
+    // resamples count samples into out, which must hold max_output(count), returns the number written
+    size_t process(const uint8_t *in, size_t count, uint8_t *out)
+    {
+        if (up == down)
+        {
+            std::copy(in, in + count, out);
+            return count;
+        }
+
+        uint8_t *begin = out;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            // history is stored twice so the newest taps samples are always contiguous
+            pos = pos ? pos - 1 : taps - 1;
+            history[pos] = history[pos + taps] = int16_t(in[i]) - 128;
+
+            const int16_t *x = &history[pos];
+
+            for (; next < up; next += down)
+            {
+                const int16_t *h = &coeffs[next * taps];
+                int32_t acc = 1 << 14;
+
+                for (size_t j = 0; j < taps; ++j)
+                {
+                    acc += x[j] * h[j];
+                }
+
+                *out++ = std::clamp((acc >> 15) + 128, 0, 255);
+            }
+
+            next -= up;
+        }
+
+        return out - begin;
+    }
+
+  private:
+    // windowed sinc lowpass at the lower of the two Nyquist rates, split into phases
+    void design()
+    {
+        const size_t length = up * taps;
+        const double cutoff = 0.45 / std::max(up, down);
+        const double center = (length - 1) / 2.0;
+
+        std::vector<double> h(length);
+
+        for (size_t k = 0; k < length; ++k)
+        {
+            const double t = k - center;
+            const double sinc = t == 0 ? 2 * cutoff : std::sin(2 * M_PI * cutoff * t) / (M_PI * t);
+            const double blackman = 0.42 - 0.5 * std::cos(2 * M_PI * k / (length - 1)) + 0.08 * std::cos(4 * M_PI * k / (length - 1));
+            h[k] = sinc * blackman;
+        }
+
+        // unity gain at DC for every phase after upsampling
+        const double gain = up / std::accumulate(h.begin(), h.end(), 0.0);
+
+        // phase p applies h[p + j * up] to the j-th newest input sample
+        for (size_t p = 0; p < up; ++p)
+        {
+            for (size_t j = 0; j < taps; ++j)
+            {
+                coeffs[p * taps + j] = int16_t(std::lround(h[p + j * up] * gain * 32767));
+            }
+        }
+    }
+
+    const size_t up;
+    const size_t down;
+    const size_t taps;
+
+    std::vector<int16_t> coeffs;
+    std::vector<int16_t> history;
+    size_t pos = 0;
+
+    // position of the next output sample within the current input sample, in 1/up steps
+    size_t next = 0;
+};
+
+// Puts a resampler in front of any decoder with a feed(const uint8_t *, size_t) method
+template <typename Decoder>
+class Resampled
+{
+  public:
+    template <typename... Args>
+    Resampled(size_t input_rate, Args &&...args)
+        : resampler(input_rate),
+          decoder(std::forward<Args>(args)...)
+    {
+    }
+
+    void feed(const uint8_t *samples, size_t count)
+    {
+        while (count)
+        {
+            const size_t n = std::min(count, block_size);
+            decoder.feed(buffer.data(), resampler.process(samples, n, buffer.data()));
+            samples += n;
+            count -= n;
+        }
+    }
+
+    void feed(const std::vector<uint8_t> &samples)
+    {
+        feed(samples.data(), samples.size());
+    }
+
+    Decoder &get()
+    {
+        return decoder;
+    }
+
+  private:
+    static constexpr size_t block_size = 4096;
+
+    Resampler resampler;
+    Decoder decoder;
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(resampler.max_output(block_size));
+};
@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Lock-free single-producer single-consumer queue
+// One thread may push and one other thread may pop, nothing else is synchronized
+template <typename T>
+class SPSCQueue
+{
+  public:
+    // the capacity is rounded up to a power of two
+    explicit SPSCQueue(size_t capacity)
+        : items(round_up(capacity)),
+          mask(items.size() - 1)
+    {
+    }
+
+    // producer side, false if the queue is full
+    bool try_push(T &&item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+
+        if (t - head.load(std::memory_order_acquire) == items.size())
+        {
+            return false;
+        }
+
+        items[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, false if the queue is empty
+    bool try_pop(T &item)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+
+        if (tail.load(std::memory_order_acquire) == h)
+        {
+            return false;
+        }
+
+        item = std::move(items[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    static size_t round_up(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+        {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::vector<T> items;
+    const size_t mask;
+
+    // each index lives on its own cache line so the two threads don't share one
+    alignas(64) std::atomic<size_t> head = { 0 };
+    alignas(64) std::atomic<size_t> tail = { 0 };
+};
+
+// Lock-free single-producer single-consumer ring of samples (or any trivially copyable type)
+// Both sides work in batches, and can also read or write the ring directly through contiguous regions:
+//     size_t n = want; T *p = ring.claim(n); ... fill p[0..n) ...; ring.commit(n);
+//     size_t n = want; const T *p = ring.peek(n); ... use p[0..n) ...; ring.release(n);
+// The capacity bounds the latency between the two sides to capacity() samples
+template <typename T>
+class SPSCRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "samples are moved with memcpy");
+
+  public:
+    // the capacity is rounded up to a power of two
+    explicit SPSCRing(size_t capacity)
+        : items(round_up(capacity)),
+          mask(items.size() - 1)
+    {
+    }
+
+    size_t capacity() const
+    {
+        return items.size();
+    }
+
+    // samples waiting to be read, exact on the consumer side, a lower bound elsewhere
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // producer side: writable region of up to n samples, n is set to its actual size (0 if full)
+    T *claim(size_t &n)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+
+        // only reload the consumer's index when the cached one says there's no room
+        if (capacity() - (t - producer_head) < n)
+        {
+            producer_head = head.load(std::memory_order_acquire);
+        }
+
+        const size_t free = capacity() - (t - producer_head);
+        const size_t contiguous = capacity() - (t & mask);
+
+        n = std::min({n, free, contiguous});
+        return &items[t & mask];
+    }
+
+    // publishes n samples written to the claimed region
+    void commit(size_t n)
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // consumer side: readable region of up to n samples, n is set to its actual size (0 if empty)
+    const T *peek(size_t &n)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+
+        if (consumer_tail - h < n)
+        {
+            consumer_tail = tail.load(std::memory_order_acquire);
+        }
+
+        const size_t used = consumer_tail - h;
+        const size_t contiguous = capacity() - (h & mask);
+
+        n = std::min({n, used, contiguous});
+        return &items[h & mask];
+    }
+
+    // hands n peeked samples back to the producer
+    void release(size_t n)
+    {
+        head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // copies up to count samples in, returns how many fit
+    size_t push(const T *samples, size_t count)
+    {
+        size_t done = 0;
+
+        // at most two regions, before and after the wrap
+        for (int part = 0; part < 2 && done < count; ++part)
+        {
+            size_t n = count - done;
+            T *out = claim(n);
+
+            if (!n)
+            {
+                break;
+            }
+
+            std::memcpy(out, samples + done, n * sizeof(T));
+            commit(n);
+            done += n;
+        }
+
+        return done;
+    }
+
+    // copies up to count samples out, returns how many there were
+    size_t pop(T *samples, size_t count)
+    {
+        size_t done = 0;
+
+        for (int part = 0; part < 2 && done < count; ++part)
+        {
+            size_t n = count - done;
+            const T *in = peek(n);
+
+            if (!n)
+            {
+                break;
+            }
+
+            std::memcpy(samples + done, in, n * sizeof(T));
+            release(n);
+            done += n;
+        }
+
+        return done;
+    }
+
+  private:
+    static size_t round_up(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+        {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::vector<T> items;
+    const size_t mask;
+
+    // consumer's line: its index and its cached copy of the producer's
+    alignas(64) std::atomic<size_t> head = { 0 };
+    size_t consumer_tail = 0;
+
+    // producer's line
+    alignas(64) std::atomic<size_t> tail = { 0 };
+    size_t producer_head = 0;
+};
@@ -1,33 +1,57 @@
 #pragma once
-#include <deque>
 #include <string>
+#include <vector>
 
 // Relatively lightweight stack trace implementation
 // (Presumably) zero overhead when no exceptions are thrown
 
 class StackableException : public std::exception
 {
-    mutable std::deque<std::string> trace;
+    struct frame
+    {
+        const char *function;
+        const char *file;
+        int line;
+    };
+
+    std::string message;
+
+    // where it was thrown, then every END() it passed through
+    // only static strings are kept, the text is put together when what() is called
+    mutable std::vector<frame> trace;
     mutable std::string text;
 
   public:
     StackableException(
         const std::string &message,
-        const std::string &function,
-        const std::string &file,
+        const char *function,
+        const char *file,
         int line)
+        : message(message),
+          trace{{function, file, line}}
     {
-        text.append(message + " in " + function + "() at " + file + ':' + std::to_string(line));
     }
 
     // const is a lie
-    void push(const std::string &function, const std::string &file, int line) const
+    void push(const char *function, const char *file, int line) const
     {
-        text.append("\n -- caught in " + function + "() at " + file + ':' + std::to_string(line));
+        trace.push_back({function, file, line});
     }
 
     const char *what() const noexcept override
     {
+        text = message;
+
+        for (size_t i = 0; i < trace.size(); ++i)
+        {
+            text.append(i ? "\n -- caught in " : " in ");
+            text.append(trace[i].function);
+            text.append("() at ");
+            text.append(trace[i].file);
+            text.push_back(':');
+            text.append(std::to_string(trace[i].line));
+        }
+
         return text.c_str();
     }
 };
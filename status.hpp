@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+
+// Error codes of the non-throwing encode/decode paths
+// Malformed frames are routine on RF, so the hot paths report them as values and leave exceptions to the CLI
+enum class APRSStatus : uint8_t
+{
+    OK,
+    MALFORMED_FRAME,
+    BAD_FCS,
+    INVALID_CALLSIGN,
+    INVALID_PATH,
+    PATH_TOO_LONG,
+};
+
+inline const char *to_string(APRSStatus status)
+{
+    switch (status)
+    {
+    case APRSStatus::OK:
+        return "OK";
+    case APRSStatus::MALFORMED_FRAME:
+        return "Malformed AX.25 frame";
+    case APRSStatus::BAD_FCS:
+        return "Frame check sequence mismatch";
+    case APRSStatus::INVALID_CALLSIGN:
+        return "Invalid callsign";
+    case APRSStatus::INVALID_PATH:
+        return "Invalid digipeater address";
+    case APRSStatus::PATH_TOO_LONG:
+        return "Digipeater path too long";
+    }
+
+    return "Unknown error";
+}
+
+// Either a value or the reason there is none, along the lines of C++23 std::expected
+template <typename T>
+class Expected
+{
+  public:
+    Expected(T value)
+        : val(std::move(value))
+    {
+    }
+
+    Expected(APRSStatus status)
+        : status(status)
+    {
+    }
+
+    explicit operator bool() const
+    {
+        return status == APRSStatus::OK;
+    }
+
+    APRSStatus error() const
+    {
+        return status;
+    }
+
+    T &value()
+    {
+        return val;
+    }
+
+    const T &value() const
+    {
+        return val;
+    }
+
+    T &operator*()
+    {
+        return val;
+    }
+
+    const T &operator*() const
+    {
+        return val;
+    }
+
+    T *operator->()
+    {
+        return &val;
+    }
+
+    const T *operator->() const
+    {
+        return &val;
+    }
+
+  private:
+    // default constructed when there is an error, so T needs a default constructor
+    T val = T();
+    APRSStatus status = APRSStatus::OK;
+};
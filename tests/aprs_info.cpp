@@ -0,0 +1,116 @@
+#include <string_view>
+
+#include "../aprs_info.hpp"
+#include "check.hpp"
+
+TEST(aprs_info, uncompressed_position)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse("!4903.50N/07201.75W-Test 001234", "APRS", info));
+
+    CHECK_EQ(info.type, APRSInfo::POSITION);
+    CHECK(!info.messaging);
+    CHECK_NEAR(info.position.latitude, 49 + 3.5 / 60, 1e-6);
+    CHECK_NEAR(info.position.longitude, -(72 + 1.75 / 60), 1e-6);
+    CHECK_EQ(info.position.symbol_table, '/');
+    CHECK_EQ(info.position.symbol, '-');
+    CHECK(info.comment == "Test 001234");
+}
+
+TEST(aprs_info, timestamped_position_with_altitude)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse("@092345z4903.50N/07201.75W>088/036/A=001234 mobile", "APRS", info));
+
+    CHECK(info.messaging);
+    CHECK(info.timestamp == "092345z");
+    CHECK(info.position.has_course);
+    CHECK_EQ(info.position.course, 88);
+    CHECK_EQ(info.position.speed, 36);
+    CHECK(info.position.has_altitude);
+    CHECK_EQ(info.position.altitude, 1234);
+}
+
+// the compressed example of the APRS 1.0 spec
+TEST(aprs_info, compressed_position)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse("=/5L!!<*e7>7P[", "APRS", info));
+
+    CHECK_EQ(info.type, APRSInfo::POSITION);
+    CHECK(info.position.compressed);
+    CHECK_NEAR(info.position.latitude, 49.5, 1e-3);
+    CHECK_NEAR(info.position.longitude, -72.75, 1e-3);
+    CHECK_EQ(info.position.symbol, '>');
+    CHECK(info.position.has_course);
+    CHECK_EQ(info.position.course, 88);
+    CHECK_EQ(info.position.speed, 36);
+}
+
+// latitude, message and longitude offset are in the destination, longitude degrees/minutes/hundredths in the info
+TEST(aprs_info, mic_e)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse("`(_fn\"Oj/]Mic-E comment", "S32U6T", info));
+
+    CHECK_EQ(info.type, APRSInfo::MIC_E);
+    CHECK_NEAR(info.position.latitude, 33 + 25.64 / 60, 1e-6);
+    CHECK_NEAR(info.position.longitude, -(12 + 7.74 / 60), 1e-6);
+    CHECK_EQ(info.mic_e_message, 3);
+    CHECK(!info.mic_e_custom);
+    CHECK_EQ(info.position.symbol, 'j');
+    CHECK_EQ(info.position.symbol_table, '/');
+}
+
+TEST(aprs_info, mic_e_bad_destination)
+{
+    APRSInfo info;
+    CHECK(!APRSInfo::Parse("`(_fn\"Oj/]", "APRS", info));
+    CHECK_EQ(info.type, APRSInfo::UNKNOWN);
+}
+
+TEST(aprs_info, message)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse(":WU2Z     :Testing{003", "APRS", info));
+
+    CHECK_EQ(info.type, APRSInfo::MESSAGE);
+    CHECK(info.message.addressee == "WU2Z");
+    CHECK(info.message.text == "Testing");
+    CHECK(info.message.id == "003");
+    CHECK(!info.message.ack);
+
+    CHECK(APRSInfo::Parse(":WU2Z     :ack003", "APRS", info));
+    CHECK(info.message.ack);
+    CHECK(info.message.id == "003");
+
+    CHECK(APRSInfo::Parse(":WU2Z     :rej003", "APRS", info));
+    CHECK(info.message.rej);
+
+    // the addressee is always 9 characters
+    CHECK(!APRSInfo::Parse(":WU2Z:Testing", "APRS", info));
+}
+
+TEST(aprs_info, telemetry)
+{
+    APRSInfo info;
+    CHECK(APRSInfo::Parse("T#005,199,000,255,073,123,01101001", "APRS", info));
+
+    CHECK_EQ(info.type, APRSInfo::TELEMETRY);
+    CHECK(info.telemetry.sequence == "005");
+    CHECK_EQ(info.telemetry.analog_count, 5);
+    CHECK_NEAR(info.telemetry.analog[0], 199, 1e-6);
+    CHECK_NEAR(info.telemetry.analog[1], 0, 1e-6);
+    CHECK_NEAR(info.telemetry.analog[4], 123, 1e-6);
+    CHECK_EQ(info.telemetry.digital, 0x69);
+}
+
+TEST(aprs_info, malformed)
+{
+    APRSInfo info;
+    CHECK(!APRSInfo::Parse("", "APRS", info));
+    CHECK(!APRSInfo::Parse("!49", "APRS", info));
+    CHECK(!APRSInfo::Parse("!4903.50X/07201.75W-", "APRS", info));
+    CHECK(!APRSInfo::Parse("@0923", "APRS", info));
+    CHECK_EQ(info.type, APRSInfo::UNKNOWN);
+}
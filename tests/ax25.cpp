@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../ax25.hpp"
+#include "check.hpp"
+
+TEST(ax25, fields)
+{
+    const auto frame = APRSPacket("N0CALL", 7, ">status text", {"WIDE1-1", "WIDE2-2*"}).Encode();
+    const AX25FrameView view(frame.data(), frame.size());
+
+    CHECK(view.IsValid());
+    CHECK(view.HasValidFCS());
+    CHECK(view.IsUI());
+    CHECK_EQ(view.PID(), 0xF0);
+    CHECK(view.Source().Matches("N0CALL", 7));
+    CHECK_EQ(view.Digipeaters(), size_t(2));
+    CHECK(view.Digipeater(0).Matches("WIDE1", 1));
+    CHECK(!view.Digipeater(0).h);
+    CHECK(view.Digipeater(1).Matches("WIDE2", 2));
+    CHECK(view.Digipeater(1).h);
+    CHECK(view.Digipeater(1).last);
+    CHECK(view.Info() == ">status text");
+}
+
+TEST(ax25, truncated)
+{
+    const auto frame = APRSPacket("N0CALL", 7, ">status text", {"WIDE1-1"}).Encode();
+
+    // every prefix too short to hold the header, control, PID and FCS
+    for (size_t size = 0; size < 3 * AX25Address::size + 2 + 2; ++size)
+    {
+        const std::vector<uint8_t> prefix(frame.begin(), frame.begin() + size);
+        CHECK(!AX25FrameView(prefix.data(), prefix.size()).IsValid());
+    }
+}
+
+// exactly the address field: the view must not read a control byte past the end
+TEST(ax25, ends_on_address_boundary)
+{
+    const auto frame = APRSPacket("N0CALL", 7, ">status text", {"WIDE1-1"}).Encode();
+    CHECK(frame[3 * AX25Address::size - 1] & 0x01);
+
+    const std::vector<uint8_t> header(frame.begin(), frame.begin() + 3 * AX25Address::size);
+    CHECK(!AX25FrameView(header.data(), header.size()).IsValid());
+}
+
+TEST(ax25, address_field_without_end)
+{
+    // no address has the extension bit set
+    std::vector<uint8_t> frame(12 * AX25Address::size, 'A' << 1);
+    CHECK(!AX25FrameView(frame.data(), frame.size()).IsValid());
+}
+
+TEST(ax25, parse_address)
+{
+    AX25Address address;
+
+    CHECK(AX25Address::Parse("WIDE2-2*", address));
+    CHECK(address.Matches("WIDE2", 2));
+    CHECK(address.h);
+
+    CHECK(AX25Address::Parse("N0CALL", address));
+    CHECK_EQ(address.ssid, 0);
+
+    CHECK(!AX25Address::Parse("TOOLONG1", address));
+    CHECK(!AX25Address::Parse("N0CALL-16", address));
+    CHECK(!AX25Address::Parse("n0call", address));
+    CHECK(!AX25Address::Parse("-1", address));
+}
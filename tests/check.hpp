@@ -0,0 +1,81 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Just enough of a unit test framework: TEST(suite, name) registers a case, CHECK and CHECK_EQ record failures
+// and carry on, so one run reports every broken expectation of a case
+namespace check
+{
+struct Case
+{
+    const char *suite;
+    const char *name;
+    void (*run)();
+};
+
+inline std::vector<Case> &cases()
+{
+    static std::vector<Case> all;
+    return all;
+}
+
+inline size_t &failures()
+{
+    static size_t count = 0;
+    return count;
+}
+
+inline bool add(const char *suite, const char *name, void (*run)())
+{
+    cases().push_back({suite, name, run});
+    return true;
+}
+
+inline void fail(const char *file, int line, const std::string &what)
+{
+    ++failures();
+    std::cerr << file << ':' << line << ": " << what << std::endl;
+}
+
+inline bool near(double a, double b, double tolerance)
+{
+    return std::abs(a - b) <= tolerance;
+}
+}
+
+#define TEST(suite, name)                                                           \
+    static void suite##_##name();                                                   \
+    static const bool suite##_##name##_added = check::add(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                             \
+    do                                                               \
+    {                                                                \
+        if (!(condition))                                            \
+        {                                                            \
+            check::fail(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+        }                                                            \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                                \
+    do                                                                                                \
+    {                                                                                                 \
+        const auto &check_a = (a);                                                                    \
+        const auto &check_b = (b);                                                                    \
+        if (!(check_a == check_b))                                                                    \
+        {                                                                                             \
+            check::fail(__FILE__, __LINE__, "CHECK_EQ(" #a ", " #b ")");                              \
+        }                                                                                             \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                                       \
+    do                                                                                    \
+    {                                                                                     \
+        if (!check::near((a), (b), (tolerance)))                                          \
+        {                                                                                 \
+            check::fail(__FILE__, __LINE__, "CHECK_NEAR(" #a ", " #b ", " #tolerance ")"); \
+        }                                                                                 \
+    } while (0)
@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../dedupe.hpp"
+#include "check.hpp"
+
+static bool check_frame(DupeCache<> &cache, const std::vector<uint8_t> &frame, uint64_t now)
+{
+    return cache.Check(AX25FrameView(frame.data(), frame.size()), now);
+}
+
+TEST(dedupe, window)
+{
+    DupeCache<> cache(30);
+    const auto frame = APRSPacket("N0CALL", 1, ">dupe").Encode();
+
+    CHECK(!check_frame(cache, frame, 100));
+    CHECK(check_frame(cache, frame, 110));
+    CHECK(check_frame(cache, frame, 130));
+
+    // the window counts from the first copy
+    CHECK(!check_frame(cache, frame, 131));
+}
+
+// frames merged from several decoders may arrive with earlier timestamps than the copy already seen
+TEST(dedupe, out_of_order)
+{
+    DupeCache<> cache(30);
+    const auto frame = APRSPacket("N0CALL", 1, ">dupe").Encode();
+
+    CHECK(!check_frame(cache, frame, 1000));
+    CHECK(check_frame(cache, frame, 990));
+    CHECK(check_frame(cache, frame, 0));
+    CHECK(check_frame(cache, frame, 1030));
+}
+
+TEST(dedupe, path_and_trailing_space_ignored)
+{
+    DupeCache<> cache(30);
+
+    CHECK(!check_frame(cache, APRSPacket("N0CALL", 1, ">dupe", {"WIDE1-1"}).Encode(), 0));
+    CHECK(check_frame(cache, APRSPacket("N0CALL", 1, ">dupe", {"DIGI*", "WIDE2-1"}).Encode(), 1));
+    CHECK(check_frame(cache, APRSPacket("N0CALL", 1, ">dupe  ").Encode(), 2));
+}
+
+TEST(dedupe, distinct)
+{
+    DupeCache<> cache(30);
+
+    CHECK(!check_frame(cache, APRSPacket("N0CALL", 1, ">one").Encode(), 0));
+    CHECK(!check_frame(cache, APRSPacket("N0CALL", 1, ">two").Encode(), 0));
+    CHECK(!check_frame(cache, APRSPacket("N0CALL", 2, ">one").Encode(), 0));
+    CHECK(!check_frame(cache, APRSPacket("N1CALL", 1, ">one").Encode(), 0));
+}
+
+// a full table evicts, it never reports a frame it hasn't seen
+TEST(dedupe, full_table)
+{
+    DupeCache<16> cache(1000);
+
+    for (int i = 0; i < 200; ++i)
+    {
+        CHECK(!cache.Check(uint64_t(i) * 0x9E3779B97F4A7C15ull, i));
+    }
+
+    CHECK(cache.Check(uint64_t(199) * 0x9E3779B97F4A7C15ull, 200));
+}
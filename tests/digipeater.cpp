@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../digipeater.hpp"
+#include "check.hpp"
+
+static std::vector<uint8_t> frame(const std::vector<std::string> &path)
+{
+    return APRSPacket("N0CALL", 1, ">digipeater test", path).Encode();
+}
+
+TEST(digipeater, wide1_used_up)
+{
+    auto f = frame({"WIDE1-1", "WIDE2-1"});
+    const auto before = f;
+
+    CHECK(Digipeater("DIGI", 3).Rewrite(f));
+
+    const AX25FrameView view(f.data(), f.size());
+    CHECK(view.HasValidFCS());
+    CHECK(view.Digipeater(0).Matches("DIGI", 3));
+    CHECK(view.Digipeater(0).h);
+    CHECK(!view.Digipeater(0).last);
+    CHECK(view.Digipeater(1).Matches("WIDE2", 1));
+    CHECK(!view.Digipeater(1).h);
+
+    // only the hop and the FCS change
+    const size_t hop = AX25FrameView::DigipeaterOffset(0);
+    for (size_t i = 0; i < f.size() - 2; ++i)
+    {
+        if (i < hop || i >= hop + AX25Address::size)
+        {
+            CHECK_EQ(f[i], before[i]);
+        }
+    }
+}
+
+TEST(digipeater, wide2_decremented)
+{
+    auto f = frame({"WIDE1-1*", "WIDE2-2"});
+
+    CHECK(Digipeater("DIGI").Rewrite(f));
+
+    const AX25FrameView view(f.data(), f.size());
+    CHECK(view.HasValidFCS());
+    CHECK(view.Digipeater(1).Matches("WIDE2", 1));
+    CHECK(!view.Digipeater(1).h);
+    CHECK(view.Digipeater(1).last);
+}
+
+TEST(digipeater, explicit_hop)
+{
+    auto f = frame({"DIGI-3", "WIDE2-1"});
+
+    CHECK(Digipeater("DIGI", 3).Rewrite(f));
+    CHECK(AX25FrameView(f.data(), f.size()).Digipeater(0).h);
+}
+
+TEST(digipeater, refused)
+{
+    const Digipeater digi("DIGI", 0, {"WIDE"}, 2);
+
+    auto own = APRSPacket("DIGI", 0, ">ours", {"WIDE1-1"}).Encode();
+    CHECK(!digi.Rewrite(own));
+
+    auto too_far = frame({"WIDE3-3"});
+    CHECK(!digi.Rewrite(too_far));
+
+    auto used = frame({"WIDE1-1*", "WIDE2-1*"});
+    CHECK(!digi.Rewrite(used));
+
+    auto other = frame({"RELAY"});
+    CHECK(!digi.Rewrite(other));
+
+    auto bad_fcs = frame({"WIDE1-1"});
+    bad_fcs.back() ^= 1;
+    const auto before = bad_fcs;
+    CHECK(!digi.Rewrite(bad_fcs));
+    CHECK(bad_fcs == before);
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "../afsk.hpp"
+#include "../aprs.hpp"
+#include "../crc.hpp"
+#include "check.hpp"
+
+static std::vector<APRSPacket> packets(size_t count)
+{
+    std::vector<APRSPacket> out;
+    for (size_t i = 0; i < count; ++i)
+    {
+        out.emplace_back("N0CALL", 1, ">batch " + std::to_string(i));
+    }
+    return out;
+}
+
+static size_t bytes(std::vector<APRSPacket> &batch)
+{
+    size_t total = 0;
+    for (auto &packet : batch)
+    {
+        total += packet.Encode().size();
+    }
+    return total;
+}
+
+// what a receiver gets out of a transmission: every frame with a valid FCS, in order
+static std::vector<std::vector<uint8_t>> decode(const std::vector<uint8_t> &samples)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    AFSK::Decoder::PLLStream decoder([&](const std::vector<uint8_t> &frame) {
+        if (CRC16::check(frame.data(), frame.size()))
+        {
+            frames.push_back(frame);
+        }
+    });
+
+    decoder.feed(samples);
+
+    // the receiver keeps listening after the transmitter keys down, or a one-flag tail never gets through its window
+    decoder.feed(std::vector<uint8_t>(8 * AFSK::Decoder::window_size, 128));
+    return frames;
+}
+
+static std::vector<std::vector<uint8_t>> encoded(std::vector<APRSPacket> &batch, size_t count)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t i = 0; i < count; ++i)
+    {
+        frames.push_back(batch[i].Encode());
+    }
+    return frames;
+}
+
+// one flag between frames is the least a receiver can split them on, the NCO never jumps between them
+// the PLL needs a few flags of txdelay to lock before the first frame
+TEST(encoder, batch_round_trip)
+{
+    for (const auto &options : {AFSK::Encoder::tx_options(), AFSK::Encoder::tx_options(4, 1, 1),
+                                AFSK::Encoder::tx_options(64, 8, 16)})
+    {
+        auto batch = packets(10);
+        std::vector<uint8_t> out(AFSK::Encoder::max_samples(
+            batch.size() * (options.gap + 1) + options.txdelay + options.txtail, bytes(batch)));
+
+        size_t samples = 0;
+        CHECK_EQ(AFSK::Encoder::EncodeBatch(batch, out.data(), out.size(), samples, options), size_t(10));
+        CHECK(samples > 0 && samples <= out.size());
+
+        // txdelay, the gaps and txtail are all there
+        const size_t flags = options.txdelay + 9 * options.gap + std::max<size_t>(options.txtail, 1);
+        CHECK(samples >= (flags * 8 + bytes(batch) * 8) * AFSK::Decoder::window_size);
+
+        out.resize(samples);
+        CHECK(decode(out) == encoded(batch, 10));
+    }
+}
+
+// the packets that don't fit are reported, not silently left out
+TEST(encoder, batch_truncated)
+{
+    const AFSK::Encoder::tx_options options;
+    auto batch = packets(10);
+    std::vector<uint8_t> out(AFSK::Encoder::max_samples(
+        3 * (options.gap + 1) + options.txdelay + options.txtail, bytes(batch) * 3 / 10));
+
+    size_t samples = 0;
+    const size_t fit = AFSK::Encoder::EncodeBatch(batch, out.data(), out.size(), samples, options);
+    CHECK(fit >= 2 && fit < 10);
+    CHECK(samples <= out.size());
+
+    // exactly the packets reported, complete with their tail
+    out.resize(samples);
+    CHECK(decode(out) == encoded(batch, fit));
+
+    std::vector<uint8_t> none(10);
+    CHECK_EQ(AFSK::Encoder::EncodeBatch(batch, none.data(), none.size(), samples, options), size_t(0));
+    CHECK_EQ(samples, size_t(0));
+}
+
+static bool encodes(int begin_marker_size, int end_marker_size)
+{
+    const auto frame = APRSPacket("N0CALL", 1, ">markers").Encode();
+
+    try
+    {
+        const auto samples = AFSK::Encoder::Encode(frame, begin_marker_size, end_marker_size);
+        return !samples.empty();
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// more leading zero bytes than flags would make the opening flag count negative
+TEST(encoder, marker_sizes)
+{
+    CHECK(encodes(1, 1));
+    CHECK(encodes(4, 4));
+    CHECK(encodes(8, 4));
+    CHECK(encodes(0, 0));
+
+    CHECK(!encodes(8, 1));
+    CHECK(!encodes(100, 2));
+    CHECK(!encodes(-1, 4));
+    CHECK(!encodes(4, -4));
+}
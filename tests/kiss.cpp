@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <vector>
+
+#include "../kiss.hpp"
+#include "check.hpp"
+
+struct Received
+{
+    uint8_t port;
+    KISS::Command command;
+    std::vector<uint8_t> payload;
+};
+
+static std::vector<Received> decode(KISS::Decoder &decoder, const std::vector<uint8_t> &stream, size_t chunk = 0)
+{
+    std::vector<Received> out;
+    auto on_frame = [&](uint8_t port, KISS::Command command, const uint8_t *data, size_t size) {
+        out.push_back({port, command, std::vector<uint8_t>(data, data + size)});
+    };
+
+    chunk = chunk ? chunk : stream.size();
+    for (size_t i = 0; i < stream.size(); i += chunk)
+    {
+        decoder.feed(stream.data() + i, std::min(chunk, stream.size() - i), on_frame);
+    }
+
+    return out;
+}
+
+TEST(kiss, escapes)
+{
+    const std::vector<uint8_t> payload = {0x01, KISS::FEND, KISS::FESC, 0x02, KISS::FESC, KISS::FEND};
+    std::vector<uint8_t> stream;
+    KISS::Encode(payload, stream, 3);
+
+    CHECK_EQ(stream.size(), payload.size() + 4 + 3);
+    CHECK_EQ(stream[1], 0x30);
+
+    KISS::Decoder decoder;
+    const auto frames = decode(decoder, stream);
+    CHECK_EQ(frames.size(), size_t(1));
+    CHECK_EQ(frames[0].port, 3);
+    CHECK_EQ(frames[0].command, KISS::DATA);
+    CHECK(frames[0].payload == payload);
+}
+
+TEST(kiss, chunked)
+{
+    std::vector<uint8_t> stream;
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        KISS::Encode(std::vector<uint8_t>(i + 1, i % 2 ? KISS::FEND : i), stream);
+    }
+
+    for (size_t chunk : {1, 2, 3, 7, 64})
+    {
+        KISS::Decoder decoder;
+        const auto frames = decode(decoder, stream, chunk);
+        CHECK_EQ(frames.size(), size_t(20));
+
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            CHECK(frames[i].payload == std::vector<uint8_t>(i + 1, i % 2 ? KISS::FEND : i));
+        }
+    }
+}
+
+TEST(kiss, commands)
+{
+    std::vector<uint8_t> stream;
+    KISS::Encode({50}, stream, 1, KISS::TXDELAY);
+    stream.insert(stream.end(), {KISS::FEND, 0xFF, KISS::FEND});
+
+    KISS::Decoder decoder;
+    const auto frames = decode(decoder, stream);
+    CHECK_EQ(frames.size(), size_t(2));
+    CHECK_EQ(frames[0].port, 1);
+    CHECK_EQ(frames[0].command, KISS::TXDELAY);
+    CHECK(frames[0].payload == std::vector<uint8_t>{50});
+
+    // RETURN is a lone type byte
+    CHECK_EQ(frames[1].command, KISS::RETURN);
+    CHECK(frames[1].payload.empty());
+}
+
+TEST(kiss, junk_and_empty_frames)
+{
+    std::vector<uint8_t> stream = {0x11, 0x22, KISS::FESC};
+    stream.insert(stream.end(), {KISS::FEND, KISS::FEND, KISS::FEND});
+    KISS::Encode({0x42}, stream);
+
+    KISS::Decoder decoder;
+    const auto frames = decode(decoder, stream);
+    CHECK_EQ(frames.size(), size_t(1));
+    CHECK(frames[0].payload == std::vector<uint8_t>{0x42});
+}
+
+// a protocol error keeps the byte after FESC
+TEST(kiss, bad_escape)
+{
+    const std::vector<uint8_t> stream = {KISS::FEND, 0x00, 0x01, KISS::FESC, 0x55, 0x02, KISS::FEND};
+
+    KISS::Decoder decoder;
+    const auto frames = decode(decoder, stream);
+    CHECK_EQ(frames.size(), size_t(1));
+    CHECK(frames[0].payload == (std::vector<uint8_t>{0x01, 0x55, 0x02}));
+}
+
+TEST(kiss, overflow)
+{
+    std::vector<uint8_t> stream;
+    KISS::Encode(std::vector<uint8_t>(16, 0xAA), stream);
+    KISS::Encode(std::vector<uint8_t>(17, 0xBB), stream);
+    KISS::Encode(std::vector<uint8_t>(3, 0xCC), stream);
+
+    // the oversized frame is dropped and the decoder picks up again at the next FEND
+    KISS::Decoder decoder(16);
+    const auto frames = decode(decoder, stream, 5);
+    CHECK_EQ(frames.size(), size_t(2));
+    CHECK(frames[0].payload == std::vector<uint8_t>(16, 0xAA));
+    CHECK(frames[1].payload == std::vector<uint8_t>(3, 0xCC));
+}
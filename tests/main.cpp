@@ -0,0 +1,36 @@
+// Runs every test case, or only those of the suites named on the command line
+// cmake --build build --target aprs-tests && ./build/aprs-tests [suite...]
+
+#include <iostream>
+#include <set>
+#include <string>
+
+#include "check.hpp"
+
+int main(int argc, char *argv[])
+{
+    const std::set<std::string> suites(argv + 1, argv + argc);
+    size_t run = 0;
+
+    for (const auto &c : check::cases())
+    {
+        if (!suites.empty() && !suites.count(c.suite))
+        {
+            continue;
+        }
+
+        const size_t before = check::failures();
+        c.run();
+        ++run;
+
+        std::cout << (check::failures() == before ? "ok   " : "FAIL ") << c.suite << '.' << c.name << std::endl;
+    }
+
+    if (!run)
+    {
+        std::cerr << "no test cases matched" << std::endl;
+        return 1;
+    }
+
+    return check::failures() ? 1 : 0;
+}
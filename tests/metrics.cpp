@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../aprs.hpp"
+#include "../metrics.hpp"
+#include "check.hpp"
+
+TEST(metrics, shards_merge)
+{
+    Metrics metrics;
+    metrics.add(Metrics::FRAMES);
+    metrics.latency(3);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        Metrics &shard = metrics.shard();
+        threads.emplace_back([&shard] {
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                shard.add(Metrics::SAMPLES, 2);
+            }
+            shard.add(Metrics::FRAMES);
+            shard.latency(3);
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto s = metrics.snapshot();
+    CHECK_EQ(s[Metrics::SAMPLES], uint64_t(Metrics::enabled ? 8000 : 0));
+    CHECK_EQ(s[Metrics::FRAMES], uint64_t(Metrics::enabled ? 5 : 0));
+    CHECK_EQ(s.latency[2], uint64_t(Metrics::enabled ? 5 : 0));
+}
+
+// the codec counts into whatever the caller passes, and nowhere without one
+TEST(metrics, codec)
+{
+    Metrics metrics;
+    std::vector<uint8_t> frame;
+
+    CHECK(APRSPacket("N0CALL", 1, ">test").TryEncode(frame, &metrics) == APRSStatus::OK);
+    CHECK(APRSPacket("N0CALL", 1, ">test").TryEncode(frame) == APRSStatus::OK);
+    CHECK(APRSPacket::TryDecode(frame, &metrics));
+
+    frame.back() ^= 1;
+    CHECK(!APRSPacket::TryDecode(frame, &metrics));
+    CHECK(!APRSPacket::TryDecode(frame));
+
+    const auto s = metrics.snapshot();
+    CHECK_EQ(s[Metrics::ENCODED], uint64_t(Metrics::enabled ? 1 : 0));
+    CHECK_EQ(s[Metrics::DECODED], uint64_t(Metrics::enabled ? 1 : 0));
+    CHECK_EQ(s[Metrics::CODEC_ERRORS], uint64_t(Metrics::enabled ? 1 : 0));
+}
@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <vector>
+
+#include "../afsk.hpp"
+#include "../aprs.hpp"
+#include "check.hpp"
+
+using Framer = AFSK::Decoder::Framer;
+
+// the tone decisions of a transmission, with the same bit stuffing and NRZI as the modulator
+// every decision is sure of itself, a positive one is mark
+static std::vector<int> decisions(const std::vector<uint8_t> &frame)
+{
+    std::vector<int> out;
+    bool marking = true;
+    int ones = 0;
+
+    auto bit = [&](bool set) {
+        if (!set)
+        {
+            marking = !marking;
+        }
+        out.push_back(marking ? 1000 : -1000);
+    };
+
+    auto flags = [&](size_t count) {
+        for (size_t i = 0; i < count * 8; ++i)
+        {
+            bit(i % 8 != 0 && i % 8 != 7);
+        }
+    };
+
+    flags(4);
+
+    for (uint8_t byte : frame)
+    {
+        for (int i = 0; i < 8; ++i, byte >>= 1)
+        {
+            const bool set = byte & 1;
+            bit(set);
+
+            ones = set ? ones + 1 : 0;
+            if (ones == 5)
+            {
+                bit(false);
+                ones = 0;
+            }
+        }
+    }
+
+    flags(2);
+    return out;
+}
+
+// feeds the decisions, returns true if a complete frame came out of the framer
+static bool run(Framer &framer, const std::vector<int> &tones)
+{
+    for (int tone : tones)
+    {
+        if (framer.push(tone))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const std::vector<uint8_t> packet = APRSPacket("N0CALL", 9, ">repair me, please", {"WIDE1-1"}).Encode();
+
+TEST(recover, clean)
+{
+    Framer framer;
+    CHECK(run(framer, decisions(packet)));
+    CHECK(framer.frame() == packet);
+
+    // nothing to repair
+    CHECK(!framer.recover());
+}
+
+// one wrong, barely-confident tone decision in the info field flips two neighbouring bits
+TEST(recover, weak_decision)
+{
+    auto tones = decisions(packet);
+    const size_t at = tones.size() - 2 * 8 - 8 * 8;
+    tones[at] = tones[at] > 0 ? -1 : 1;
+
+    Framer framer;
+    CHECK(run(framer, tones));
+    CHECK(!CRC16::check(framer.frame().data(), framer.frame().size()));
+
+    CHECK(framer.recover(2));
+    CHECK(framer.frame() == packet);
+}
+
+TEST(recover, limits)
+{
+    auto tones = decisions(packet);
+    const size_t at = tones.size() - 2 * 8 - 8 * 8;
+    tones[at] = tones[at] > 0 ? -1 : 1;
+
+    // a tone error is two bit errors
+    Framer single;
+    CHECK(run(single, tones));
+    CHECK(!single.recover(1));
+
+    Framer none;
+    CHECK(run(none, tones));
+    CHECK(!none.recover(2, 0));
+}
+
+// errors the decoder was sure about aren't among the candidates
+TEST(recover, confident_errors)
+{
+    auto tones = decisions(packet);
+    for (size_t at : {tones.size() - 2 * 8 - 8 * 8, tones.size() - 2 * 8 - 8 * 12})
+    {
+        tones[at] = -tones[at];
+    }
+
+    Framer framer;
+    CHECK(run(framer, tones));
+    CHECK(!framer.recover(2));
+}
@@ -0,0 +1,128 @@
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "../spsc.hpp"
+#include "check.hpp"
+
+TEST(spsc, capacity_rounded_up)
+{
+    CHECK_EQ(SPSCRing<uint8_t>(1000).capacity(), size_t(1024));
+    CHECK_EQ(SPSCRing<uint8_t>(1024).capacity(), size_t(1024));
+}
+
+TEST(spsc, wraparound)
+{
+    SPSCRing<int16_t> ring(16);
+    std::vector<int16_t> in(11), out(11);
+    int16_t next = 0, expected = 0;
+
+    // 11 doesn't divide 16, so copies keep straddling the wrap point
+    for (int round = 0; round < 50; ++round)
+    {
+        for (auto &x : in)
+        {
+            x = next++;
+        }
+
+        CHECK_EQ(ring.push(in.data(), in.size()), in.size());
+        CHECK_EQ(ring.size(), in.size());
+        CHECK_EQ(ring.pop(out.data(), out.size()), out.size());
+
+        for (auto x : out)
+        {
+            CHECK_EQ(x, expected++);
+        }
+    }
+}
+
+TEST(spsc, full_and_empty)
+{
+    SPSCRing<uint8_t> ring(8);
+    std::vector<uint8_t> data(12, 7);
+
+    CHECK_EQ(ring.push(data.data(), data.size()), size_t(8));
+    CHECK_EQ(ring.push(data.data(), 1), size_t(0));
+
+    size_t n = 100;
+    ring.claim(n);
+    CHECK_EQ(n, size_t(0));
+
+    CHECK_EQ(ring.pop(data.data(), data.size()), size_t(8));
+    CHECK_EQ(ring.pop(data.data(), 1), size_t(0));
+}
+
+// claim/peek never hand out a region across the wrap point
+TEST(spsc, contiguous_regions)
+{
+    SPSCRing<uint8_t> ring(8);
+    std::vector<uint8_t> data(6);
+
+    ring.push(data.data(), 6);
+    ring.pop(data.data(), 6);
+
+    size_t n = 8;
+    ring.claim(n);
+    CHECK_EQ(n, size_t(2));
+    ring.commit(2);
+
+    n = 8;
+    ring.claim(n);
+    CHECK_EQ(n, size_t(6));
+    ring.commit(6);
+
+    n = 8;
+    ring.peek(n);
+    CHECK_EQ(n, size_t(2));
+    ring.release(2);
+
+    n = 8;
+    ring.peek(n);
+    CHECK_EQ(n, size_t(6));
+}
+
+TEST(spsc, threads)
+{
+    SPSCRing<uint32_t> ring(64);
+    const uint32_t total = 200000;
+    uint64_t sum = 0;
+
+    std::thread producer([&] {
+        uint32_t next = 0, block[7];
+        while (next < total)
+        {
+            const size_t n = std::min<uint32_t>(7, total - next);
+            std::iota(block, block + n, next);
+            const size_t pushed = ring.push(block, n);
+            next += pushed;
+
+            // the consumer may share the CPU
+            if (!pushed)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0, block[5];
+    while (expected < total)
+    {
+        const size_t n = ring.pop(block, 5);
+        if (!n)
+        {
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            CHECK_EQ(block[i], expected);
+            sum += block[i];
+            ++expected;
+        }
+    }
+
+    producer.join();
+    CHECK_EQ(sum, uint64_t(total) * (total - 1) / 2);
+}
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../wav.hpp"
+#include "check.hpp"
+
+// little-endian RIFF pieces
+static void le16(std::vector<uint8_t> &out, uint16_t v)
+{
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void le32(std::vector<uint8_t> &out, uint32_t v)
+{
+    le16(out, v & 0xFFFF);
+    le16(out, v >> 16);
+}
+
+static void chunk(std::vector<uint8_t> &out, const char *id, const std::vector<uint8_t> &body, uint32_t size)
+{
+    out.insert(out.end(), id, id + 4);
+    le32(out, size);
+    out.insert(out.end(), body.begin(), body.end());
+
+    // chunks are padded to an even size
+    if (body.size() & 1)
+    {
+        out.push_back(0);
+    }
+}
+
+static void chunk(std::vector<uint8_t> &out, const char *id, const std::vector<uint8_t> &body)
+{
+    chunk(out, id, body, body.size());
+}
+
+// the 16-byte fmt body, or the 40-byte WAVE_FORMAT_EXTENSIBLE one carrying format in its subformat GUID
+static std::vector<uint8_t> fmt(uint16_t format, uint16_t channels, uint32_t rate, uint16_t bits, bool extensible = false)
+{
+    std::vector<uint8_t> body;
+    le16(body, extensible ? WAVFormat::EXTENSIBLE : format);
+    le16(body, channels);
+    le32(body, rate);
+    le32(body, rate * channels * bits / 8);
+    le16(body, channels * bits / 8);
+    le16(body, bits);
+
+    if (extensible)
+    {
+        le16(body, 22);
+        le16(body, bits);
+        le32(body, 0);
+        le16(body, format);
+        static const uint8_t guid_tail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+        body.insert(body.end(), guid_tail, guid_tail + sizeof(guid_tail));
+    }
+
+    return body;
+}
+
+static std::vector<uint8_t> riff(const std::vector<uint8_t> &chunks, uint32_t size)
+{
+    std::vector<uint8_t> out = {'R', 'I', 'F', 'F'};
+    le32(out, size);
+    out.insert(out.end(), {'W', 'A', 'V', 'E'});
+    out.insert(out.end(), chunks.begin(), chunks.end());
+    return out;
+}
+
+static std::vector<uint8_t> riff(const std::vector<uint8_t> &chunks)
+{
+    return riff(chunks, 4 + chunks.size());
+}
+
+static std::vector<uint8_t> wav(const std::vector<uint8_t> &format, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> chunks;
+    chunk(chunks, "fmt ", format);
+    chunk(chunks, "data", data);
+    return riff(chunks);
+}
+
+struct memory_source
+{
+    const uint8_t *p;
+    const uint8_t *end;
+
+    size_t read(void *out, size_t n)
+    {
+        n = std::min<size_t>(n, end - p);
+        if (n)
+        {
+            memcpy(out, p, n);
+        }
+
+        p += n;
+        return n;
+    }
+
+    bool skip(size_t n)
+    {
+        if (n > size_t(end - p))
+        {
+            return false;
+        }
+
+        p += n;
+        return true;
+    }
+};
+
+// parses file, and converts one channel of the data that follows the header
+static std::vector<uint8_t> convert(const std::vector<uint8_t> &file, size_t channel, WAVFormat &format)
+{
+    memory_source src = {file.data(), file.data() + file.size()};
+    const uint32_t size = WAVFormat::parse(src, format);
+
+    std::vector<uint8_t> out(size / format.frame_size());
+    format.convert(src.p, out.size(), channel, out.data());
+    return out;
+}
+
+static bool parses(const std::vector<uint8_t> &file)
+{
+    memory_source src = {file.data(), file.data() + file.size()};
+    WAVFormat format;
+
+    try
+    {
+        WAVFormat::parse(src, format);
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// a file on disk for the readers, removed again on scope exit
+struct temp_file
+{
+    std::string path;
+
+    explicit temp_file(const std::vector<uint8_t> &content)
+    {
+        char name[] = "/tmp/aprs-tests-XXXXXX";
+        const int fd = mkstemp(name);
+        path = name;
+
+        if (fd >= 0)
+        {
+            (void)!write(fd, content.data(), content.size());
+            close(fd);
+        }
+    }
+
+    ~temp_file()
+    {
+        unlink(path.c_str());
+    }
+};
+
+TEST(wav, pcm16)
+{
+    std::vector<uint8_t> data;
+    for (int16_t s : {0, 32767, -32768, 256, -256})
+    {
+        le16(data, s);
+    }
+
+    WAVFormat format;
+    const auto out = convert(wav(fmt(WAVFormat::PCM, 1, 22050, 16), data), 0, format);
+
+    CHECK_EQ(format.format, WAVFormat::PCM);
+    CHECK_EQ(format.sample_rate, uint32_t(22050));
+    CHECK_EQ(format.bits_per_sample, 16);
+    CHECK(out == (std::vector<uint8_t>{0x80, 0xFF, 0x00, 0x81, 0x7F}));
+}
+
+TEST(wav, stereo_channel)
+{
+    WAVFormat format;
+
+    // left, right interleaved
+    const std::vector<uint8_t> data8 = {1, 101, 2, 102, 3, 103};
+    CHECK(convert(wav(fmt(WAVFormat::PCM, 2, 9600, 8), data8), 0, format) == (std::vector<uint8_t>{1, 2, 3}));
+    CHECK(convert(wav(fmt(WAVFormat::PCM, 2, 9600, 8), data8), 1, format) == (std::vector<uint8_t>{101, 102, 103}));
+    CHECK_EQ(format.frame_size(), size_t(2));
+
+    std::vector<uint8_t> data16;
+    for (int16_t s : {0, 32767, -32768, 0})
+    {
+        le16(data16, s);
+    }
+
+    CHECK(convert(wav(fmt(WAVFormat::PCM, 2, 48000, 16), data16), 1, format) == (std::vector<uint8_t>{0xFF, 0x80}));
+}
+
+TEST(wav, float32)
+{
+    std::vector<uint8_t> data;
+    for (float f : {0.0f, 0.5f, -1.0f, 2.0f, -2.0f})
+    {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        le32(data, bits);
+    }
+
+    WAVFormat format;
+    const auto out = convert(wav(fmt(WAVFormat::FLOAT, 1, 44100, 32), data), 0, format);
+
+    CHECK_EQ(format.format, WAVFormat::FLOAT);
+    CHECK(out == (std::vector<uint8_t>{128, 192, 0, 255, 0}));
+}
+
+TEST(wav, extensible)
+{
+    WAVFormat format;
+
+    std::vector<uint8_t> data;
+    le16(data, 32767);
+    CHECK(convert(wav(fmt(WAVFormat::PCM, 1, 8000, 16, true), data), 0, format) == std::vector<uint8_t>{0xFF});
+    CHECK_EQ(format.format, WAVFormat::PCM);
+
+    data.clear();
+    le32(data, 0x3F000000); // 0.5f
+    CHECK(convert(wav(fmt(WAVFormat::FLOAT, 1, 8000, 32, true), data), 0, format) == std::vector<uint8_t>{192});
+    CHECK_EQ(format.format, WAVFormat::FLOAT);
+}
+
+// unknown chunks anywhere before data, odd-sized ones with their pad byte, and a fmt chunk with cbSize
+TEST(wav, chunks_before_data)
+{
+    std::vector<uint8_t> chunks;
+    chunk(chunks, "LIST", {'a', 'b', 'c'});
+    auto format_body = fmt(WAVFormat::PCM, 1, 9600, 8);
+    format_body.insert(format_body.end(), {0, 0});
+    chunk(chunks, "fmt ", format_body);
+    chunk(chunks, "fact", {1, 2, 3, 4, 5});
+    chunk(chunks, "data", {10, 20, 30});
+
+    WAVFormat format;
+    CHECK(convert(riff(chunks), 0, format) == (std::vector<uint8_t>{10, 20, 30}));
+    CHECK_EQ(format.sample_rate, uint32_t(9600));
+}
+
+TEST(wav, malformed)
+{
+    const auto good = wav(fmt(WAVFormat::PCM, 1, 9600, 8), {1, 2});
+    CHECK(parses(good));
+
+    auto not_riff = good;
+    not_riff[0] = 'X';
+    CHECK(!parses(not_riff));
+
+    // every prefix that stops short of the data chunk header
+    for (size_t size = 0; size < good.size() - 2; ++size)
+    {
+        CHECK(!parses(std::vector<uint8_t>(good.begin(), good.begin() + size)));
+    }
+
+    std::vector<uint8_t> chunks;
+    chunk(chunks, "data", {1, 2});
+    chunk(chunks, "fmt ", fmt(WAVFormat::PCM, 1, 9600, 8));
+    CHECK(!parses(riff(chunks)));
+
+    CHECK(!parses(wav(fmt(WAVFormat::PCM, 1, 9600, 24), {0, 0, 0})));
+    CHECK(!parses(wav(fmt(WAVFormat::FLOAT, 1, 9600, 16), {0, 0})));
+    CHECK(!parses(wav(fmt(WAVFormat::PCM, 0, 9600, 8), {0})));
+    CHECK(!parses(wav(fmt(WAVFormat::PCM, 1, 0, 8), {0})));
+    CHECK(!parses(wav(std::vector<uint8_t>(14, 0), {0})));
+
+    // an unknown chunk claiming more than there is
+    chunks.clear();
+    chunk(chunks, "fmt ", fmt(WAVFormat::PCM, 1, 9600, 8));
+    chunk(chunks, "LIST", {1, 2}, 1000);
+    CHECK(!parses(riff(chunks)));
+}
+
+// streaming writers don't know the sizes yet: the data runs to the end of the file
+TEST(wav, placeholder_sizes)
+{
+    for (uint32_t placeholder : {0u, 0xFFFFFFFFu})
+    {
+        std::vector<uint8_t> chunks;
+        chunk(chunks, "fmt ", fmt(WAVFormat::PCM, 2, 9600, 16));
+        chunk(chunks, "data", {}, placeholder);
+
+        // a trailing partial frame is dropped
+        for (int16_t s : {100, -100, 200, -200, 300})
+        {
+            le16(chunks, s);
+        }
+
+        const temp_file file(riff(chunks, placeholder));
+
+        WAVReader reader(file.path);
+        CHECK_EQ(reader.Frames(), size_t(2));
+
+        uint8_t mapped[2] = { };
+        CHECK_EQ(reader.Read(1, 0, 2, mapped), size_t(2));
+        CHECK_EQ(mapped[0], uint8_t(0xFF ^ 0x80));
+        CHECK_EQ(mapped[1], uint8_t(0xFF ^ 0x80));
+
+        WAVStreamReader stream(file.path);
+        uint8_t streamed[4] = { };
+        CHECK_EQ(stream.Read(0, streamed, 4), size_t(2));
+        CHECK_EQ(streamed[0], uint8_t(0x80));
+        CHECK_EQ(streamed[1], uint8_t(0x80));
+        CHECK_EQ(stream.Read(0, streamed, 4), size_t(0));
+    }
+}
+
+// a real size stops the readers at the end of the chunk, whatever follows it
+TEST(wav, data_size)
+{
+    std::vector<uint8_t> chunks;
+    chunk(chunks, "fmt ", fmt(WAVFormat::PCM, 1, 9600, 8));
+    chunk(chunks, "data", {1, 2, 3});
+    chunk(chunks, "LIST", {9, 9, 9, 9});
+
+    const temp_file file(riff(chunks));
+
+    WAVReader reader(file.path);
+    CHECK_EQ(reader.Size(), size_t(3));
+    CHECK(reader.IsNative());
+
+    WAVStreamReader stream(file.path);
+    uint8_t out[8] = { };
+    CHECK_EQ(stream.Read(0, out, 8), size_t(3));
+    CHECK_EQ(out[2], 3);
+}
@@ -0,0 +1,585 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "afsk.hpp"
+#include "crc.hpp"
+#include "kiss.hpp"
+#include "stack_guards.hpp"
+
+// Host side of a KISS TNC: decoded frames go out to every connected host, data frames from the hosts come back
+// to be transmitted. Hosts connect over TCP on localhost or open the slave side of a pseudo-terminal
+// One thread runs the epoll loop, send() may be called from any other. Frames sent between two wakeups are
+// KISS-encoded once into a shared block, which reaches every host in one writev along with whatever it still owes
+class TNC
+{
+  public:
+    // a frame from a host, FCS appended
+    struct frame
+    {
+        uint8_t port;
+        std::vector<uint8_t> data;
+    };
+
+    // every data frame read in one pass of the loop, and the TXDELAY/TXTAIL the hosts asked for
+    using transmit_callback = std::function<void(const std::vector<frame> &, const AFSK::Encoder::tx_options &)>;
+
+    // bytes a host may fall behind by: TCP hosts are dropped, a pty that nobody reads just loses them
+    static const size_t max_queued = 1 << 20;
+
+    // iovecs per writev
+    static const size_t max_iov = 64;
+
+    // writing to a host that went away must not kill the process, so SIGPIPE is ignored from here on
+    // SIGINT and SIGTERM make run() return instead: they are blocked in the calling thread and every thread it
+    // starts afterwards, and read from a signalfd by the loop
+    explicit TNC(transmit_callback on_transmit)
+        : on_transmit(std::move(on_transmit))
+    {
+        std::signal(SIGPIPE, SIG_IGN);
+
+        sigset_t stop_signals;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+        poller = epoll_create1(EPOLL_CLOEXEC);
+        wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        signals = signalfd(-1, &stop_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        if (poller < 0 || wakeup < 0 || signals < 0)
+        {
+            const std::string error = std::strerror(errno);
+            close_all();
+            throw EXCEPTION("Can't set up the event loop: " + error);
+        }
+
+        watch(wakeup, EPOLLIN);
+        watch(signals, EPOLLIN);
+    }
+
+    TNC(const TNC &) = delete;
+    TNC &operator=(const TNC &) = delete;
+
+    ~TNC()
+    {
+        close_all();
+    }
+
+    // accepts hosts on 127.0.0.1:port, returns the port (port 0 takes any free one)
+    uint16_t listen(uint16_t port)
+    {
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+        const int on = 1;
+        sockaddr_in address = { };
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+            bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 ||
+            ::listen(listener, 16) < 0)
+        {
+            throw EXCEPTION("Can't listen on port " + std::to_string(port) + ": " + std::strerror(errno));
+        }
+
+        socklen_t size = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr *>(&address), &size);
+
+        watch(listener, EPOLLIN);
+        return ntohs(address.sin_port);
+    }
+
+    // opens a raw pseudo-terminal, returns the path hosts open
+    std::string open_pty()
+    {
+        const int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+        if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+        {
+            if (master >= 0)
+            {
+                close(master);
+            }
+
+            throw EXCEPTION(std::string("Can't open a pseudo-terminal: ") + std::strerror(errno));
+        }
+
+        const std::string path = ptsname(master);
+
+        // held open so the master doesn't hang up whenever no host has the slave open
+        pty_slave = open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+        termios raw;
+        if (pty_slave < 0 || tcgetattr(pty_slave, &raw) < 0)
+        {
+            close(master);
+            throw EXCEPTION("Can't open " + path + ": " + std::strerror(errno));
+        }
+
+        cfmakeraw(&raw);
+        tcsetattr(pty_slave, TCSANOW, &raw);
+
+        add_host(master, true);
+        return path;
+    }
+
+    // queues a decoded frame (FCS included, as the decoders deliver it) for every host, from any thread
+    void send(uint8_t port, const uint8_t *data, size_t size)
+    {
+        if (size <= 2)
+        {
+            return;
+        }
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            KISS::Encode(data, size - 2, pending, port);
+
+            // one wakeup per batch, the loop takes everything queued by then
+            wake = !notified;
+            notified = true;
+        }
+
+        if (wake)
+        {
+            notify();
+        }
+    }
+
+    void send(uint8_t port, const std::vector<uint8_t> &frame)
+    {
+        send(port, frame.data(), frame.size());
+    }
+
+    // makes run() return, from any thread
+    void stop()
+    {
+        stopping = true;
+        notify();
+    }
+
+    // the event loop, until stop(), SIGINT or SIGTERM
+    void run()
+    {
+        epoll_event events[64];
+
+        while (!stopping)
+        {
+            const int n = epoll_wait(poller, events, 64, -1);
+
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                throw EXCEPTION(std::string("epoll_wait failed: ") + std::strerror(errno));
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+
+                if (fd == wakeup)
+                {
+                    uint64_t count;
+                    while (read(wakeup, &count, sizeof(count)) > 0)
+                    {
+                    }
+
+                    distribute();
+                }
+                else if (fd == signals)
+                {
+                    signalfd_siginfo info;
+                    while (read(signals, &info, sizeof(info)) > 0)
+                    {
+                    }
+
+                    stopping = true;
+                }
+                else if (fd == listener)
+                {
+                    accept_hosts();
+                }
+                else if (auto it = hosts.find(fd); it != hosts.end() && !it->second->closing)
+                {
+                    host &h = *it->second;
+
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    {
+                        receive(h);
+                    }
+
+                    if (events[i].events & EPOLLOUT && !h.closing)
+                    {
+                        flush(h);
+                    }
+                }
+            }
+
+            // closed only now, so a new host can't take over an fd that still has an event in this batch
+            for (auto it = hosts.begin(); it != hosts.end();)
+            {
+                if (it->second->closing)
+                {
+                    close(it->first);
+                    it = hosts.erase(it);
+                    --connected;
+
+                    if (!accepting)
+                    {
+                        watch(listener, EPOLLIN, EPOLL_CTL_MOD);
+                        accepting = true;
+                    }
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            if (!batch.empty())
+            {
+                on_transmit(batch, options);
+                batch.clear();
+            }
+        }
+    }
+
+    // hosts currently connected, the pty counts as one, from any thread
+    size_t host_count() const
+    {
+        return connected;
+    }
+
+  private:
+    struct host
+    {
+        int fd;
+        bool pty;
+
+        // the TNC adds the FCS, so hosts send up to max_frame_size - 2 bytes
+        KISS::Decoder decoder{AFSK::Decoder::max_frame_size - 2};
+
+        // shared blocks still to be written, and how far into the first one
+        std::deque<std::shared_ptr<const std::vector<uint8_t>>> queue;
+        size_t offset = 0;
+        size_t queued = 0;
+
+        // EPOLLOUT is armed while the socket is full
+        bool waiting = false;
+        bool closing = false;
+    };
+
+    void watch(int fd, uint32_t events, int op = EPOLL_CTL_ADD)
+    {
+        epoll_event event = { };
+        event.events = events;
+        event.data.fd = fd;
+
+        if (epoll_ctl(poller, op, fd, &event) < 0)
+        {
+            throw EXCEPTION(std::string("epoll_ctl failed: ") + std::strerror(errno));
+        }
+    }
+
+    void notify()
+    {
+        const uint64_t one = 1;
+        (void)!write(wakeup, &one, sizeof(one));
+    }
+
+    void add_host(int fd, bool pty)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        auto h = std::make_unique<host>();
+        h->fd = fd;
+        h->pty = pty;
+
+        watch(fd, EPOLLIN);
+        hosts[fd] = std::move(h);
+        ++connected;
+    }
+
+    void accept_hosts()
+    {
+        while (true)
+        {
+            const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+
+                // out of descriptors or memory: EPOLLIN would stay ready and spin the loop, so stop
+                // listening until a host goes away
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    watch(listener, 0, EPOLL_CTL_MOD);
+                    accepting = false;
+                }
+
+                return;
+            }
+
+            // frames are small and latency matters more than packing them
+            const int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+            add_host(fd, false);
+        }
+    }
+
+    // takes everything send() queued as one block and hands it to every host
+    void distribute()
+    {
+        auto block = std::make_shared<std::vector<uint8_t>>();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            block->swap(pending);
+            notified = false;
+        }
+
+        if (block->empty())
+        {
+            return;
+        }
+
+        for (auto &[fd, h] : hosts)
+        {
+            if (h->closing)
+            {
+                continue;
+            }
+
+            if (h->queued + block->size() > max_queued)
+            {
+                if (!h->pty)
+                {
+                    drop(*h);
+                    continue;
+                }
+
+                // the next frame starts with FEND, so a host that comes back later resyncs
+                h->queue.clear();
+                h->offset = h->queued = 0;
+            }
+
+            h->queue.push_back(block);
+            h->queued += block->size();
+            flush(*h);
+        }
+    }
+
+    // writes as much of the queue as the host takes, in batches of up to max_iov blocks
+    void flush(host &h)
+    {
+        while (!h.queue.empty())
+        {
+            iovec iov[max_iov];
+            size_t count = 0;
+
+            for (auto it = h.queue.begin(); it != h.queue.end() && count < max_iov; ++it, ++count)
+            {
+                const size_t skip = count ? 0 : h.offset;
+                iov[count].iov_base = const_cast<uint8_t *>((*it)->data()) + skip;
+                iov[count].iov_len = (*it)->size() - skip;
+            }
+
+            ssize_t written = writev(h.fd, iov, count);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    drop(h);
+                    return;
+                }
+
+                break;
+            }
+
+            h.queued -= written;
+
+            while (written)
+            {
+                const size_t left = h.queue.front()->size() - h.offset;
+
+                if (size_t(written) < left)
+                {
+                    h.offset += written;
+                    break;
+                }
+
+                written -= left;
+                h.queue.pop_front();
+                h.offset = 0;
+            }
+        }
+
+        // only wait for room while there's something to write
+        if (h.waiting != !h.queue.empty())
+        {
+            h.waiting = !h.queue.empty();
+            watch(h.fd, h.waiting ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+        }
+    }
+
+    void receive(host &h)
+    {
+        uint8_t buffer[4096];
+
+        while (true)
+        {
+            const ssize_t n = read(h.fd, buffer, sizeof(buffer));
+
+            if (n > 0)
+            {
+                h.decoder.feed(buffer, n, [&](uint8_t port, KISS::Command command, const uint8_t *data, size_t size) {
+                    command_received(port, command, data, size);
+                });
+                continue;
+            }
+
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            // the pty only reports errors while its slave is being reopened, it stays
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                drop(h);
+            }
+
+            return;
+        }
+    }
+
+    void command_received(uint8_t port, KISS::Command command, const uint8_t *data, size_t size)
+    {
+        switch (command)
+        {
+        case KISS::DATA:
+            if (size)
+            {
+                frame &f = batch.emplace_back();
+                f.port = port;
+                f.data.assign(data, data + size);
+                f.data.resize(size + 2);
+                CRC16::patch(f.data.data(), f.data.size());
+            }
+            break;
+
+        case KISS::TXDELAY:
+        case KISS::TXTAIL:
+            if (size)
+            {
+                // 10 ms units to flags, rounded up
+                const size_t flags = (data[0] * KISS::time_unit_ms * AFSK::baud_rate + 7999) / 8000;
+                (command == KISS::TXDELAY ? options.txdelay : options.txtail) = flags;
+            }
+            break;
+
+        // the channel access parameters mean nothing to an audio output, RETURN has no KISS mode to leave
+        default:
+            break;
+        }
+    }
+
+    void drop(host &h)
+    {
+        if (h.pty)
+        {
+            h.queue.clear();
+            h.offset = h.queued = 0;
+            return;
+        }
+
+        h.closing = true;
+    }
+
+    void close_all()
+    {
+        for (auto &[fd, h] : hosts)
+        {
+            close(fd);
+        }
+
+        hosts.clear();
+
+        for (int fd : {listener, wakeup, signals, poller, pty_slave})
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+
+        listener = wakeup = signals = poller = pty_slave = -1;
+    }
+
+    transmit_callback on_transmit;
+    AFSK::Encoder::tx_options options;
+
+    int poller = -1;
+    int wakeup = -1;
+    int signals = -1;
+    int listener = -1;
+    int pty_slave = -1;
+
+    // false while the listener is paused for lack of descriptors
+    bool accepting = true;
+
+    std::unordered_map<int, std::unique_ptr<host>> hosts;
+
+    // data frames read in this pass of the loop
+    std::vector<frame> batch;
+
+    // KISS bytes from send() not yet handed to the hosts
+    std::mutex mutex;
+    std::vector<uint8_t> pending;
+    bool notified = false;
+
+    std::atomic<size_t> connected{0};
+    std::atomic<bool> stopping{false};
+};
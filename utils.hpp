@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdlib>
 #include <cstdint>
 #include <memory>
@@ -9,9 +10,46 @@
 
 namespace utils
 {
-static uint8_t lut[] = {
-#include "sine.txt"
-};
+constexpr double pi = 3.14159265358979323846;
 
-const size_t lut_size = sizeof(lut) / sizeof(*lut);
-}
\ No newline at end of file
+// compile-time sine, good to ~1e-15 (std::sin isn't constexpr)
+constexpr double sin(double x)
+{
+    // reduce to [-pi, pi)
+    const double turns = (x + pi) / (2 * pi);
+    long long whole = static_cast<long long>(turns);
+    whole -= turns < whole;
+    x -= whole * 2 * pi;
+
+    double term = x, sum = x;
+    for (int k = 1; k < 15; ++k)
+    {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + pi / 2);
+}
+
+constexpr long long round(double x)
+{
+    return x < 0 ? -static_cast<long long>(-x + 0.5) : static_cast<long long>(x + 0.5);
+}
+
+// one full period of a signed 16-bit sine, plus the first entry again so interpolation never wraps
+template <size_t N>
+constexpr std::array<int16_t, N + 1> sine_table()
+{
+    std::array<int16_t, N + 1> table = { };
+    for (size_t i = 0; i <= N; ++i)
+    {
+        table[i] = round(32767 * sin(2 * pi * i / N));
+    }
+    return table;
+}
+}
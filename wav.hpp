@@ -1,88 +1,650 @@
 #pragma once
-#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stack_guards.hpp"
+#include "utils.hpp"
+
+struct WAVFormat
+{
+    enum : uint16_t
+    {
+        PCM = 1,
+        FLOAT = 3,
+        EXTENSIBLE = 0xFFFE,
+    };
+
+    // channels a stream can be split into
+    static const size_t max_channels = 32;
+
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits_per_sample = 0;
+
+    // bytes per sample of all channels
+    size_t frame_size() const
+    {
+        return channels * bits_per_sample / 8;
+    }
+
+    // converts one channel of interleaved frames to the unsigned 8-bit samples the demodulators take
+    void convert(const uint8_t *frames, size_t count, size_t channel, uint8_t *out) const
+    {
+        const size_t stride = frame_size();
+        const uint8_t *p = frames + channel * bits_per_sample / 8;
+
+        switch (bits_per_sample)
+        {
+            case 8:
+                for (size_t i = 0; i < count; ++i, p += stride)
+                {
+                    out[i] = *p;
+                }
+                break;
+
+            case 16:
+                for (size_t i = 0; i < count; ++i, p += stride)
+                {
+                    out[i] = uint8_t(p[1] ^ 0x80);
+                }
+                break;
+
+            case 32:
+                for (size_t i = 0; i < count; ++i, p += stride)
+                {
+                    float f;
+                    memcpy(&f, p, sizeof(f));
+                    out[i] = uint8_t(std::clamp(std::lround(f * 128) + 128, 0l, 255l));
+                }
+                break;
+        }
+    }
+
+    // reads the RIFF header from src up to the start of the data chunk, returns the data chunk size
+    // src needs read(void *, size_t) -> size_t and skip(size_t) -> bool
+    template <typename Source>
+    static uint32_t parse(Source &src, WAVFormat &fmt)
+    {
+        uint8_t riff[12];
+
+        if (src.read(riff, sizeof(riff)) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            throw EXCEPTION("Not a RIFF/WAVE file");
+        }
+
+        bool have_format = false;
 
-extern "C" {
-#include "C-Wav-Lib/wav.h"
-}
+        // chunks may come in any order and there may be any number of unknown ones
+        for (;;)
+        {
+            uint8_t chunk[8];
 
+            if (src.read(chunk, sizeof(chunk)) != sizeof(chunk))
+            {
+                throw EXCEPTION("No data chunk found");
+            }
+
+            const uint32_t size = le32(chunk + 4);
+
+            if (memcmp(chunk, "fmt ", 4) == 0)
+            {
+                uint8_t body[40] = { };
+
+                if (size < 16 || src.read(body, std::min<size_t>(size, sizeof(body))) != std::min<size_t>(size, sizeof(body)) ||
+                    (size > sizeof(body) && !src.skip(size - sizeof(body))) || ((size & 1) && !src.skip(1)))
+                {
+                    throw EXCEPTION("Truncated fmt chunk");
+                }
+
+                fmt.format = le16(body);
+                fmt.channels = le16(body + 2);
+                fmt.sample_rate = le32(body + 4);
+                fmt.bits_per_sample = le16(body + 14);
+
+                // the actual format is the first 2 bytes of the subformat GUID
+                if (fmt.format == EXTENSIBLE && size >= 26)
+                {
+                    fmt.format = le16(body + 24);
+                }
+
+                const bool supported =
+                    (fmt.format == PCM && (fmt.bits_per_sample == 8 || fmt.bits_per_sample == 16)) ||
+                    (fmt.format == FLOAT && fmt.bits_per_sample == 32);
+
+                if (!supported || fmt.channels == 0 || fmt.channels > max_channels || fmt.sample_rate == 0)
+                {
+                    throw EXCEPTION("Unsupported WAV format " + std::to_string(fmt.format) + ", " +
+                                    std::to_string(fmt.bits_per_sample) + " bits, " + std::to_string(fmt.channels) + " channels");
+                }
+
+                have_format = true;
+            }
+            else if (memcmp(chunk, "data", 4) == 0)
+            {
+                if (!have_format)
+                {
+                    throw EXCEPTION("data chunk before fmt chunk");
+                }
+
+                return size;
+            }
+            else if (!src.skip(size + (size & 1)))
+            {
+                throw EXCEPTION("Truncated chunk");
+            }
+        }
+    }
+
+  private:
+    static uint16_t le16(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t le32(const uint8_t *p)
+    {
+        return le16(p) | (uint32_t(le16(p + 2)) << 16);
+    }
+};
+
+// Streaming WAV writer: samples go out in fixed-size blocks as they come
+// The RIFF sizes are patched on close when the output is seekable, pipes and stdout ("-") get placeholders
 class WAVWriter
 {
+    const std::string name;
     const size_t sample_rate;
+    const uint16_t bits_per_sample;
+    const uint16_t channels;
 
     FILE *f = nullptr;
+    bool seekable = false;
+
+    std::vector<uint8_t> block;
+    size_t used = 0;
 
-    std::vector<uint8_t> samples;
-    wav_sample_t sample = {1, 1, 1, nullptr};
+    // bytes of sample data written so far, buffered ones included
+    size_t written = 0;
 
   public:
-    WAVWriter(const std::string &name, const size_t sample_rate)
-        : sample_rate(sample_rate)
+    static const size_t block_size = 64 * 1024;
+
+    WAVWriter(const std::string &name, const size_t sample_rate, uint16_t bits_per_sample = 8, uint16_t channels = 1)
+        : name(name != "-" ? name : "stdout"),
+          sample_rate(sample_rate),
+          bits_per_sample(bits_per_sample),
+          channels(channels),
+          block(block_size)
     {
+        if (bits_per_sample != 8 && bits_per_sample != 16)
+        {
+            throw EXCEPTION("Only 8 and 16 bit output is supported");
+        }
+
         f = name != "-" ? fopen(name.c_str(), "wb") : stdout;
-        samples.reserve(sample_rate);
+
+        if (!f)
+        {
+            throw EXCEPTION("Can't open " + name);
+        }
+
+        seekable = fseek(f, 0, SEEK_SET) == 0;
+
+        // readers treat 0xFFFFFFFF as "until the end of the stream"
+        if (!write_header(seekable ? 0 : 0xFFFFFFFF))
+        {
+            const std::string error = std::strerror(errno);
+            if (f != stdout)
+            {
+                fclose(f);
+            }
+            throw EXCEPTION("Can't write " + this->name + ": " + error);
+        }
     }
 
+    WAVWriter(const WAVWriter &) = delete;
+    WAVWriter &operator=(const WAVWriter &) = delete;
+
+    // errors can't be reported from here, close() first to find out whether everything got written
     ~WAVWriter()
     {
-        write_wav_header(
-            f,
-            1,
-            sample_rate,
-            1,
-            samples.size() + sample_rate / 10 * 2);
+        finish();
+    }
+
+    // writes what's left and the final sizes, and closes the file, nothing can be put afterwards
+    void close()
+    {
+        check(finish());
+    }
+
+    void put(uint8_t sample)
+    {
+        if (used == block.size())
+        {
+            flush_block();
+        }
+
+        block[used++] = sample;
+        ++written;
+    }
 
-        std::vector<uint8_t> silence(sample_rate / 10, 128);
+    // 8-bit samples (or raw little-endian bytes of any format)
+    void put(const uint8_t *samples, size_t count)
+    {
+        written += count;
 
-        // surround actual data with silence for easier playback
-        sample.DataSize = silence.size();
-        sample.sampleData = silence.data();
-        //write_wav_sample(f, &sample);
+        // large writes skip the block
+        if (count >= block.size())
+        {
+            flush_block();
+            check(write(samples, count));
+            return;
+        }
 
-        sample.DataSize = samples.size();
-        sample.sampleData = samples.data();
-        write_wav_sample(f, &sample);
+        if (used + count > block.size())
+        {
+            flush_block();
+        }
 
-        sample.DataSize = silence.size();
-        sample.sampleData = silence.data();
-        //write_wav_sample(f, &sample);
+        memcpy(block.data() + used, samples, count);
+        used += count;
+    }
 
-        fclose(f);
+    void put(const std::vector<uint8_t> &samples)
+    {
+        put(samples.data(), samples.size());
     }
 
-    void put(uint8_t sample)
+    // 16-bit samples
+    void put(const int16_t *samples, size_t count)
     {
-        // don't care about RAM, care about speed
-        if (samples.capacity() == samples.size())
-            samples.reserve(samples.capacity() * 2);
+        static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "WAV data is little-endian");
+        put(reinterpret_cast<const uint8_t *>(samples), count * sizeof(*samples));
+    }
 
-        samples.push_back(sample);
+    void put(const std::vector<int16_t> &samples)
+    {
+        put(samples.data(), samples.size());
     }
 
+    // samples written so far
     size_t size() const
     {
-        return samples.size();
+        return written / (bits_per_sample / 8);
+    }
+
+    // hands everything written so far to the file or pipe, for writers that must not sit on samples
+    void flush()
+    {
+        flush_block();
+        check(fflush(f) == 0);
+    }
+
+  private:
+    void flush_block()
+    {
+        const size_t size = used;
+        used = 0;
+        check(write(block.data(), size));
+    }
+
+    bool write(const void *data, size_t size)
+    {
+        return !size || fwrite(data, 1, size, f) == size;
+    }
+
+    // a full disk or a closed pipe must not go unnoticed
+    void check(bool ok)
+    {
+        if (!ok)
+        {
+            throw EXCEPTION("Can't write " + name + ": " + std::strerror(errno));
+        }
+    }
+
+    // returns false if anything failed, errno tells the first error
+    bool finish()
+    {
+        if (!f)
+        {
+            return true;
+        }
+
+        int error = 0;
+
+        if (!write(block.data(), used) ||
+            (seekable && (fseek(f, 0, SEEK_SET) != 0 || !write_header(std::min<size_t>(written, 0xFFFFFFFF - 36)))))
+        {
+            error = errno;
+        }
+
+        if ((f != stdout ? fclose(f) : fflush(f)) != 0 && !error)
+        {
+            error = errno;
+        }
+
+        f = nullptr;
+        used = 0;
+        errno = error;
+        return !error;
+    }
+
+    bool write_header(uint32_t data_size)
+    {
+        const uint32_t byte_rate = sample_rate * channels * bits_per_sample / 8;
+        const uint16_t block_align = channels * bits_per_sample / 8;
+        const uint32_t riff_size = data_size == 0xFFFFFFFF ? data_size : 36 + data_size;
+
+        uint8_t header[44];
+        memcpy(header, "RIFF", 4);
+        put_le32(header + 4, riff_size);
+        memcpy(header + 8, "WAVEfmt ", 8);
+        put_le32(header + 16, 16);
+        put_le16(header + 20, WAVFormat::PCM);
+        put_le16(header + 22, channels);
+        put_le32(header + 24, sample_rate);
+        put_le32(header + 28, byte_rate);
+        put_le16(header + 32, block_align);
+        put_le16(header + 34, bits_per_sample);
+        memcpy(header + 36, "data", 4);
+        put_le32(header + 40, data_size);
+
+        return write(header, sizeof(header));
+    }
+
+    static void put_le16(uint8_t *p, uint16_t v)
+    {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    static void put_le32(uint8_t *p, uint32_t v)
+    {
+        put_le16(p, v & 0xFFFF);
+        put_le16(p + 2, v >> 16);
     }
 };
 
+// Memory-mapped WAV file: the data chunk is exposed in place, nothing is copied up front
 class WAVReader
 {
-    std::vector<uint8_t> samples;
-    wav_sample_t sample = {1, 1, 1, nullptr};
+    struct memory_source
+    {
+        const uint8_t *p;
+        const uint8_t *end;
+
+        size_t read(void *out, size_t n)
+        {
+            n = std::min<size_t>(n, end - p);
+            memcpy(out, p, n);
+            p += n;
+            return n;
+        }
+
+        bool skip(size_t n)
+        {
+            if (n > size_t(end - p))
+            {
+                return false;
+            }
+
+            p += n;
+            return true;
+        }
+    };
+
+    WAVFormat format;
+
+    void *map = MAP_FAILED;
+    size_t map_size = 0;
+
+    const uint8_t *data = nullptr;
+    size_t data_size = 0;
 
   public:
     WAVReader(const std::string &name)
     {
-        FILE *f = name != "-" ? fopen(name.c_str(), "rb") : stdin;
-        wav_header_t hdr;
-        read_wav_header(f, &hdr);
-        samples.resize(hdr.Data.Subchunk2Size);
-        fread(samples.data(), 1, hdr.Data.Subchunk2Size, f);
-        fclose(f);
+        int fd = open(name.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            throw EXCEPTION("Can't open " + name);
+        }
+
+        DEFER(close(fd));
+
+        struct stat st;
+
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            throw EXCEPTION("Can't stat " + name + " or it is empty");
+        }
+
+        map_size = st.st_size;
+        map = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map == MAP_FAILED)
+        {
+            throw EXCEPTION("Can't map " + name);
+        }
+
+        // decoding reads the file front to back
+        madvise(map, map_size, MADV_SEQUENTIAL);
+
+        memory_source src = {static_cast<const uint8_t *>(map), static_cast<const uint8_t *>(map) + map_size};
+
+        try
+        {
+            uint32_t size = WAVFormat::parse(src, format);
+
+            // streamed files often carry a placeholder size
+            data = src.p;
+            data_size = std::min<size_t>(size ? size : SIZE_MAX, src.end - src.p);
+            data_size -= data_size % format.frame_size();
+        }
+        catch (...)
+        {
+            munmap(map, map_size);
+            throw;
+        }
+    }
+
+    WAVReader(const WAVReader &) = delete;
+    WAVReader &operator=(const WAVReader &) = delete;
+
+    ~WAVReader()
+    {
+        munmap(map, map_size);
+    }
+
+    const WAVFormat &Format() const
+    {
+        return format;
+    }
+
+    // raw, interleaved data chunk
+    const uint8_t *Data() const
+    {
+        return data;
+    }
+
+    size_t Size() const
+    {
+        return data_size;
+    }
+
+    size_t Frames() const
+    {
+        return data_size / format.frame_size();
     }
 
-    const std::vector<uint8_t> &Samples() const
+    // true if Data() already holds samples the demodulators can take as is
+    bool IsNative() const
     {
-        return samples;
+        return format.channels == 1 && format.bits_per_sample == 8;
     }
-};
\ No newline at end of file
+
+    // converts count frames of one channel starting at frame first, returns the number converted
+    size_t Read(size_t channel, size_t first, size_t count, uint8_t *out) const
+    {
+        if (channel >= format.channels || first >= Frames())
+        {
+            return 0;
+        }
+
+        count = std::min(count, Frames() - first);
+        format.convert(data + first * format.frame_size(), count, channel, out);
+        return count;
+    }
+};
+
+// Chunked WAV reader for files, pipes and stdin ("-")
+// Only a fixed-size block is held in memory
+class WAVStreamReader
+{
+    struct file_source
+    {
+        FILE *f;
+
+        size_t read(void *out, size_t n)
+        {
+            return fread(out, 1, n, f);
+        }
+
+        // pipes can't seek, so skipping is reading
+        bool skip(size_t n)
+        {
+            uint8_t buf[256];
+
+            while (n)
+            {
+                size_t chunk = std::min(n, sizeof(buf));
+
+                if (fread(buf, 1, chunk, f) != chunk)
+                {
+                    return false;
+                }
+
+                n -= chunk;
+            }
+
+            return true;
+        }
+    };
+
+    FILE *f;
+    WAVFormat format;
+
+    // data bytes left, SIZE_MAX if unknown
+    size_t remaining;
+
+    std::vector<uint8_t> block;
+
+  public:
+    static const size_t block_frames = 16384;
+
+    WAVStreamReader(const std::string &name)
+        : f(name != "-" ? fopen(name.c_str(), "rb") : stdin)
+    {
+        if (!f)
+        {
+            throw EXCEPTION("Can't open " + name);
+        }
+
+        try
+        {
+            file_source src = {f};
+            uint32_t size = WAVFormat::parse(src, format);
+
+            // streaming writers put 0 or 0xFFFFFFFF here as they don't know the size yet
+            remaining = size == 0 || size == 0xFFFFFFFF ? SIZE_MAX : size;
+        }
+        catch (...)
+        {
+            Close();
+            throw;
+        }
+
+        block.resize(block_frames * format.frame_size());
+    }
+
+    WAVStreamReader(const WAVStreamReader &) = delete;
+    WAVStreamReader &operator=(const WAVStreamReader &) = delete;
+
+    ~WAVStreamReader()
+    {
+        Close();
+    }
+
+    const WAVFormat &Format() const
+    {
+        return format;
+    }
+
+    // reads up to count frames, converts one channel into out, returns the number of frames read (0 at the end)
+    size_t Read(size_t channel, uint8_t *out, size_t count)
+    {
+        if (channel >= format.channels)
+        {
+            return 0;
+        }
+
+        uint8_t *outs[WAVFormat::max_channels] = { };
+        outs[channel] = out;
+        return Read(outs, count);
+    }
+
+    // same, but splits all channels at once - out[c] receives channel c, null entries are skipped
+    size_t Read(uint8_t *const *out, size_t count)
+    {
+        const size_t frame_size = format.frame_size();
+        size_t total = 0;
+
+        while (total < count && remaining)
+        {
+            size_t want = std::min({count - total, block_frames, remaining / frame_size});
+            size_t got = fread(block.data(), 1, want * frame_size, f) / frame_size;
+
+            if (got == 0)
+            {
+                break;
+            }
+
+            remaining = remaining == SIZE_MAX ? SIZE_MAX : remaining - got * frame_size;
+
+            for (size_t c = 0; c < format.channels && c < WAVFormat::max_channels; ++c)
+            {
+                if (out[c])
+                {
+                    format.convert(block.data(), got, c, out[c] + total);
+                }
+            }
+
+            total += got;
+        }
+
+        return total;
+    }
+
+  private:
+    void Close()
+    {
+        if (f && f != stdin)
+        {
+            fclose(f);
+        }
+
+        f = nullptr;
+    }
+};